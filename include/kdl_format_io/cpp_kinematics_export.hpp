@@ -0,0 +1,84 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef CPP_KINEMATICS_EXPORT_H
+#define CPP_KINEMATICS_EXPORT_H
+
+#include <string>
+
+#include "symoro_par_model.hpp"
+
+namespace KDL {
+    class Tree;
+}
+
+namespace kdl_format_io {
+
+/** Generates a standalone C++ translation unit that computes the forward kinematics
+ *  and the Jacobians of all the links of a KDL::Tree.
+ *
+ *  The generated code is straight-line, does not allocate memory and depends only on <cmath>.
+ *  It defines the function
+ *      void function_name(const double * q, double * poses, double * jacobians)
+ *  together with the constants function_name_nr_of_dofs, function_name_nr_of_links and
+ *  the array function_name_link_names. Fixed joints and parameters that are zero or one
+ *  are constant-folded. The joint values are ordered as the joints of the tree (q_nr).
+ * \param tree the KDL::Tree, whose joints must have unitary scale
+ * \param function_name the name of the generated function (a valid C identifier)
+ * \param code the resulting C++ code
+ * returns true on success, false on failure
+ */
+bool treeToCppKinematicsString(const KDL::Tree& tree, const std::string& function_name, std::string& code);
+
+bool treeToCppKinematicsFile(const std::string& file, const KDL::Tree& tree, const std::string& function_name);
+
+/** Generates a standalone C++ translation unit that computes the forward kinematics
+ *  and the Jacobians of all the links of a Type 0 or Type 1 par model, as treeToCppKinematicsString.
+ *  Symbolic geometric parameters are folded using their current (bound) values.
+ *  The links are Link1, Link2, ... and the joint values are ordered as the DOFs of the tree
+ *  created by treeFromParModel.
+ * \param par_model the par model
+ * \param function_name the name of the generated function (a valid C identifier)
+ * \param code the resulting C++ code
+ * returns true on success, false on failure
+ */
+bool parModelToCppKinematicsString(const symoro_par_model& par_model, const std::string& function_name, std::string& code);
+
+bool parModelToCppKinematicsFile(const std::string& file, const symoro_par_model& par_model, const std::string& function_name);
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_CODE_EVALUATOR_H
+#define SYMORO_CODE_EVALUATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <Eigen/Core>
+
+namespace kdl_format_io {
+
+/**
+ * Runtime evaluator of the C code generated by SyMoRo+ (for example the dynamics regressor),
+ * that avoids compiling the (possibly huge) generated translation units.
+ *
+ * The code is parsed as a listing of assignments (t1=q(0); ... DG1MX2=...;) into an
+ * expression DAG: constant subexpressions are folded, common subexpressions are shared
+ * and only the nodes needed by the outputs are evaluated. Declarations, control statements,
+ * comments and preprocessor directives are ignored.
+ *
+ * Variables that are read before being assigned are the inputs of the listing: the calls
+ * to unknown functions with integer arguments (q(0), q_dot(1), ...) and member accesses
+ * (base_vel.rot[0]) are inputs named as in the code. Assignments to NAME(i,j) or NAME(i)
+ * define the elements of the output matrix NAME (for example dynamics_regressor).
+ */
+class symoro_code_evaluator
+{
+public:
+    symoro_code_evaluator();
+
+    bool loadFromString(const std::string & code);
+
+    bool loadFromFile(const std::string & file_name);
+
+    int getNrOfInputs() const { return input_names.size(); }
+
+    const std::string & getInputName(const int index) const { return input_names[index]; }
+
+    /**
+     * returns the index of the input, -1 if the listing has no such input
+     */
+    int getInputIndex(const std::string & name) const;
+
+    void setInput(const int index, const double value) { values[input_nodes[index]] = value; }
+
+    /**
+     * returns false if the listing has no such input
+     */
+    bool setInput(const std::string & name, const double value);
+
+    /**
+     * Number of operations evaluated by evaluate(), after folding and sharing subexpressions
+     */
+    int getNrOfOperations() const { return program.size(); }
+
+    /**
+     * Evaluate the outputs for the current value of the inputs
+     */
+    void evaluate();
+
+    /**
+     * Get the output matrix NAME, as computed by the last evaluate().
+     * Elements not assigned by the listing are set to zero, the matrix
+     * is resized only if it is too small.
+     * returns false if the listing has no such output
+     */
+    bool getOutput(const std::string & name, Eigen::MatrixXd & output) const;
+
+private:
+    enum node_op { CONSTANT, INPUT, NEG, ADD, SUB, MUL, DIV, POW, ATAN2,
+                   SIN, COS, TAN, ASIN, ACOS, ATAN, SQRT, EXP, LOG, ABS, SIGN };
+
+    struct node
+    {
+        int op;
+        int a;
+        int b;
+        double value;   ///< value of CONSTANT nodes
+
+        bool operator<(const node & other) const;
+    };
+
+    std::vector<node> nodes;
+    std::map<node,int> unique_nodes;            ///< for sharing common subexpressions
+    std::map<std::string,int> variables;        ///< node currently assigned to each variable
+    std::vector<std::string> input_names;
+    std::vector<int> input_nodes;
+    std::map<std::string, std::map<std::pair<int,int>,int> > outputs;
+
+    std::vector<int> program;                   ///< nodes to evaluate, in topological order
+    std::vector<double> values;
+
+    static double apply(const int op, const double a, const double b);
+    void clear();
+    int addNode(const int op, int a, int b=-1, const double value=0.0);
+    int addConstant(const double value);
+    int getVariableNode(const std::string & name);
+    bool parseStatement(const std::string & statement);
+    bool parseExpression(const char * & p, int & result);
+    bool parseTerm(const char * & p, int & result);
+    bool parseFactor(const char * & p, int & result);
+    bool parsePrimary(const char * & p, int & result);
+    void compile();
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_BATCH_H
+#define SYMORO_PAR_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include <kdl/tree.hpp>
+
+#include "symoro_par_model.hpp"
+
+namespace kdl_format_io {
+
+/**
+ * Instantiation of the same par model structure with many sets of values
+ * of its geometric parameters, for example for Monte-Carlo tolerance analysis.
+ *
+ * The parameters are the symbolic geometric parameters of the model (for example D3
+ * or RL4) followed by the numerical entries added with addParameter(). The .par file
+ * is parsed and the tree of the model is built only once: each instance copies the
+ * segments of this tree, and computes again only the ones of the links that depend
+ * on the parameters, from a copy of the model with the values bound.
+ * If OpenMP is enabled the instances are built in parallel.
+ */
+class symoro_par_batch
+{
+public:
+    /**
+     * Field of the Theta entries for addParameter(), the other fields
+     * are the ones of symoro_par_model::geometric_field
+     */
+    static const int THETA_FIELD = symoro_par_model::NR_OF_GEOMETRIC_FIELDS;
+
+    /**
+     * \param par_model a Type 0 or Type 1 par model
+     * \param consider_root_link_inertia as in treeFromParModel
+     */
+    symoro_par_batch(const symoro_par_model & par_model, const bool consider_root_link_inertia=true);
+
+    bool isValid() const { return valid; }
+
+    /**
+     * Add a parameter that replaces the numerical value of an entry of the model
+     * (for Theta, the constant offset of the joint variable)
+     * \param name the name of the parameter
+     * \param link the index (0 based) of the link
+     * \param field one of symoro_par_model::geometric_field, or THETA_FIELD
+     * returns the index of the new parameter, -1 on failure
+     */
+    int addParameter(const std::string & name, const int link, const int field);
+
+    int getNrOfParameters() const { return parameter_names.size(); }
+
+    const std::string & getParameterName(const int parameter) const { return parameter_names[parameter]; }
+
+    /**
+     * Get the values of the parameters in the model (0 for the symbolic ones)
+     */
+    void getNominalParameters(std::vector<double> & values) const;
+
+    /**
+     * Build a par model for each set of parameters
+     * \param values the nr_of_instances*getNrOfParameters() values, one set after the other
+     * \param models the resulting models
+     * returns true on success, false on failure
+     */
+    bool instantiateModels(const double * values, const int nr_of_instances, std::vector<symoro_par_model> & models) const;
+
+    /**
+     * Build a KDL::Tree for each set of parameters, equal to the one
+     * built by treeFromParModel from the corresponding model
+     * \param values the nr_of_instances*getNrOfParameters() values, one set after the other
+     * \param trees the resulting trees
+     * returns true on success, false on failure
+     */
+    bool instantiateTrees(const double * values, const int nr_of_instances, std::vector<KDL::Tree> & trees) const;
+
+private:
+    symoro_par_model model;
+    bool consider_root_link_inertia;                    ///< as in treeFromParModel, for the names of the trees
+    KDL::Tree nominal_tree;                             ///< tree of the model, template of the instances
+
+    std::vector<std::string> parameter_names;
+    std::vector<symoro_par_symbolic_entry> entries;     ///< entries of the model that depend on the parameters
+
+    bool valid;
+
+    bool checkValues(const double * values, const int nr_of_instances) const;
+    void bindValues(const double * values, symoro_par_model & instance) const;
+};
+
+}
+
+#endif
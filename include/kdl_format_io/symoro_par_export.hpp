@@ -0,0 +1,95 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_EXPORT_H
+#define SYMORO_PAR_EXPORT_H
+
+#include <string>
+
+#include "symoro_par_model.hpp"
+
+namespace KDL {
+    class Tree;
+}
+
+namespace kdl_format_io {
+
+/** Constructs a SyMoRo par model from a KDL::Tree, computing the
+ *  modified Denavit-Hartenberg parameters (Khalil 1986) of its segments.
+ *
+ *  The segments are numbered in depth-first order (link 0 is the root of the tree),
+ *  rotational and prismatic joints become Sigma 0 and 1, fixed joints Sigma 2.
+ *  The z axis of the frame of each link is its joint axis, the x axis is the common
+ *  normal with the axis of its first child, and the inertia of the segments is expressed
+ *  in these frames. The inertia of the root of the tree is not exported.
+ *  Each transform is checked against DH_Khalil1986_Tree, for two joint positions.
+ * \param tree the KDL::Tree, whose joints must have unitary scale
+ * \param par_model the resulting par model (Type 0 for chains, Type 1 otherwise)
+ * returns true on success, false on failure
+ */
+bool treeToParModel(const KDL::Tree& tree, symoro_par_model& par_model);
+
+/** Writes a par model in the SyMoRo .par format.
+ *  Joint variables are written as t1, t2, ... in Theta of rotational joints, symbolic
+ *  parameters with their names and if the model has no inertial parameters the
+ *  usual symbols (XX1, XY1, ...) are written.
+ * \param par_model the par model
+ * \param parfile_content the resulting content of the .par file
+ * returns true on success, false on failure
+ */
+bool parModelToString(const symoro_par_model& par_model, std::string& parfile_content);
+
+bool parModelToFile(const std::string& parfile_name, const symoro_par_model& par_model);
+
+/** Constructs the content of a SyMoRo .par file, given a KDL::Tree
+ * \param tree the KDL::Tree
+ * \param parfile_content the resulting content of the .par file
+ * \param robot_name the name of the robot written in the .par file
+ * returns true on success, false on failure
+ */
+bool treeToSymoroParString(const KDL::Tree& tree, std::string& parfile_content, const std::string & robot_name="par_generated_by_kdl_format_io");
+
+/** Constructs a SyMoRo .par file, given a KDL::Tree
+ * \param parfile_name the name of the .par file to write
+ * \param tree the KDL::Tree
+ * \param robot_name the name of the robot written in the .par file
+ * returns true on success, false on failure
+ */
+bool treeToSymoroParFile(const std::string& parfile_name, const KDL::Tree& tree, const std::string & robot_name="par_generated_by_kdl_format_io");
+
+}
+
+#endif
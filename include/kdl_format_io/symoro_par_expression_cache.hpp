@@ -0,0 +1,116 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_EXPRESSION_CACHE_H
+#define SYMORO_PAR_EXPRESSION_CACHE_H
+
+#include <string>
+#include <list>
+#include <map>
+
+namespace kdl_format_io {
+
+/**
+ * Cache of the values of the expressions found in .par files, indexed by their text.
+ *
+ * Most elements of real .par files are repeated literal expressions ("0", "Pi/2", "-Pi/2", "t1", ...):
+ * an expression found in the cache is not compiled again. As in the import, the joint variables
+ * and the unknown symbols of an expression are zero, so its value depends only on its text.
+ *
+ * The cache holds at most a given number of expressions, discarding the least recently used
+ * ones. A cache can be shared by the imports of many files, also from many threads.
+ */
+class symoro_par_expression_cache
+{
+public:
+    /**
+     * \param max_nr_of_expressions the maximum number of expressions kept in the cache
+     */
+    symoro_par_expression_cache(const int max_nr_of_expressions=4096);
+    ~symoro_par_expression_cache();
+
+    /**
+     * Look for the expression in the characters [begin,end)
+     * returns true if it is in the cache, storing its value in value
+     */
+    bool lookup(const char * begin, const char * end, double & value);
+
+    /**
+     * Add the expression in the characters [begin,end) with its value
+     */
+    void insert(const char * begin, const char * end, const double value);
+
+    /**
+     * Remove all the expressions and reset the statistics
+     */
+    void clear();
+
+    int getNrOfExpressions() const;
+    int getMaxNrOfExpressions() const { return max_nr_of_expressions; }
+
+    /**
+     * Statistics of the calls to lookup(), since the creation or the last clear()
+     */
+    long getNrOfLookups() const;
+    long getNrOfHits() const;
+    double getHitRate() const;
+
+private:
+    struct cache_entry
+    {
+        double value;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    int max_nr_of_expressions;
+    std::map<std::string,cache_entry> entries;
+    std::list<std::string> lru;         ///< expressions from the most to the least recently used
+    long nr_of_lookups;
+    long nr_of_hits;
+
+    void * lock;                        ///< mutex of the platform (pthread_mutex_t or CRITICAL_SECTION)
+
+    void acquire() const;
+    void release() const;
+
+    //Not copyable, as the lock can not be shared
+    symoro_par_expression_cache(const symoro_par_expression_cache &);
+    symoro_par_expression_cache & operator=(const symoro_par_expression_cache &);
+};
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_FK_H
+#define SYMORO_PAR_FK_H
+
+#include <vector>
+
+#include <kdl/frames.hpp>
+
+#include "symoro_par_model.hpp"
+
+namespace kdl_format_io {
+
+/**
+ * Forward kinematics solver working directly on the geometric parameters of a
+ * symoro_par_model, without building a KDL::Tree.
+ *
+ * The constant part of each link transform (the one depending on gamma, B, Alpha and d)
+ * is computed once, so the solver only needs one sine and one cosine for each
+ * revolute joint. The poses of the links are expressed with respect to the base (Link0),
+ * and are computed in the order of the links, that is a topological order
+ * as in a valid model the parent Ant[l] of each link l precedes it.
+ *
+ * The joint values are ordered as the DOFs of the KDL::Tree created by treeFromParModel,
+ * so the solver can be used to cross-check TreeFkSolverPos_iterative (and vice versa).
+ */
+class symoro_par_fk_solver
+{
+public:
+    symoro_par_fk_solver(const symoro_par_model & par_model);
+
+    /**
+     * Recompute the constant part of the link transforms, for example
+     * after binding the symbolic geometric parameters of the model
+     * returns true on success, false if the model is not a valid Type 0 or Type 1 model
+     */
+    bool setModel(const symoro_par_model & par_model);
+
+    bool isValid() const { return valid; }
+
+    int getNrOfLinks() const { return links.size(); }
+
+    int getNrOfDOFs() const { return nr_of_dofs; }
+
+    /**
+     * Compute the poses of all the links
+     * \param q the getNrOfDOFs() joint values
+     * \param poses array of getNrOfLinks() frames, poses[l] is set to the pose of link l (Link(l+1))
+     * returns true on success, false if the solver is not valid
+     */
+    bool JntToCart(const double * q, KDL::Frame * poses) const;
+
+    bool JntToCart(const std::vector<double> & q, std::vector<KDL::Frame> & poses) const;
+
+    /**
+     * Compute the poses of all the links for several configurations
+     * \param q the nr_of_configurations*getNrOfDOFs() joint values, one configuration after the other
+     * \param poses array of nr_of_configurations*getNrOfLinks() frames, one set of poses after the other
+     * returns true on success, false if the solver is not valid
+     */
+    bool JntToCartBatch(const double * q, const int nr_of_configurations, KDL::Frame * poses) const;
+
+private:
+    struct link_constants
+    {
+        int parent;         ///< index of the parent link, -1 for the base
+        int dof;            ///< index of the joint value, -1 for fixed joints
+        int sigma;          ///< joint type, as in symoro_par_model::Sigma
+        KDL::Frame A;       ///< Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)
+        double theta;       ///< constant part of theta
+        double r;           ///< constant part of r
+        double ct, st;      ///< cos and sin of theta, for non revolute joints
+    };
+
+    std::vector<link_constants> links;
+    int nr_of_dofs;
+    bool valid;
+};
+
+}
+
+#endif
@@ -38,15 +38,20 @@
 #define SYMORO_PAR_IMPORT_H
 
 #include <string>
+#include <vector>
+#include <istream>
 
 #include "symoro_par_model.hpp"
 
 namespace KDL {
     class Tree;
+    class Twist;
 }
 
 namespace kdl_format_io {
 
+class symoro_par_expression_cache;
+
 /** Constructs a KDL tree from a .par file, given the file name
  *  The .par file is produced by the Symoro+ software 
  * \param file The filename from where to read the .par file
@@ -78,9 +83,60 @@ bool treeFromSymoroParString(const std::string& parfile_content, KDL::Tree& tree
  */
 bool treeFromParModel(const symoro_par_model & par_model, KDL::Tree& tree, const bool consider_root_link_inertia=true);
 
-bool parModelFromFile(const std::string& parfile_name, symoro_par_model& tree);
+/** Binds the values of the symbolic geometric parameters (for example D3 or RL4) of a par model
+ *  and rebuilds a KDL tree previously created with treeFromParModel from the same model (with
+ *  any value of consider_root_link_inertia), keeping its names, without reparsing the .par file
+ * \param par_model the par model, the entries using a symbolic geometric parameter are updated
+ * \param values the values of the parameters, in the order of par_model.geometric_parameter_names
+ * \param tree the KDL Tree to update, it is left unchanged if it was not created from par_model
+ * returns true on success, false on failure
+ */
+bool bindGeometricParameters(symoro_par_model& par_model, const std::vector<double>& values, KDL::Tree& tree);
+
+/** Computes the derivatives of the frames of the links with respect to a symbolic geometric
+ *  parameter, so that the gradients for the calibration do not need to reparse the model
+ *  with perturbed values of the parameter
+ * \param par_model the par model, with the current values of the parameters bound
+ * \param parameter the index of the parameter in par_model.geometric_parameter_names
+ * \param derivatives derivatives[l] is the derivative of the frame of link l with respect to its
+ *                    parent link: the velocity of its origin and its angular velocity, expressed
+ *                    in the frame of the parent link, for a unit rate of the parameter.
+ *                    It is zero for the links that do not depend on the parameter
+ * \param joint_positions optional joint_positions[l] is the position of the joint of link l,
+ *                        if empty the derivatives are computed with all the joints at zero
+ * returns true on success, false on failure
+ */
+bool geometricParameterFrameDerivatives(const symoro_par_model& par_model, const int parameter, std::vector<KDL::Twist>& derivatives,
+                                        const std::vector<double>& joint_positions=std::vector<double>());
+
+/** Binds the values of the symbolic inertial parameters of a par model and rebuilds, with the
+ *  new inertia, a KDL tree previously created with treeFromParModel from the same model,
+ *  keeping its names, without reparsing the .par file
+ * \param par_model the par model, the entries using a symbolic inertial parameter are updated
+ * \param values the values of the parameters, in the order of par_model.inertial_parameter_names
+ * \param tree the KDL Tree to update, it is left unchanged if it was not created from par_model
+ * returns true on success, false on failure
+ */
+bool bindInertialParameters(symoro_par_model& par_model, const std::vector<double>& values, KDL::Tree& tree);
+
+/** Parses a SyMoRo .par file, given the file name
+ * \param expression_cache optional cache of the values of the expressions, that can be
+ *                         shared by the imports of many files (see parModelFromStream)
+ */
+bool parModelFromFile(const std::string& parfile_name, symoro_par_model& tree, symoro_par_expression_cache * expression_cache=0);
 
-bool parModelFromString(const std::string& parfile_content, symoro_par_model& tree);
+bool parModelFromString(const std::string& parfile_content, symoro_par_model& tree, symoro_par_expression_cache * expression_cache=0);
+
+/** Parses a SyMoRo .par file read from a stream, chunk by chunk.
+ *  The memory used does not depend on the size of the file, but only on
+ *  the length of the longest definition of a scalar or of a vector element
+ * \param parfile_stream the stream containing the .par file
+ * \param tree the resulting par model
+ * \param expression_cache optional cache of the values of the expressions: the expressions
+ *                         found in it are not compiled, and the ones of the file are added to it
+ * returns true on success, false on failure
+ */
+bool parModelFromStream(std::istream& parfile_stream, symoro_par_model& tree, symoro_par_expression_cache * expression_cache=0);
 
 }
 
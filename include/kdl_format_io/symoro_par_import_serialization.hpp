@@ -83,6 +83,36 @@ bool treeSerializationFromSymoroParString(const std::string& parfile_content, KD
  */
 bool treeSerializationFromParModel(const symoro_par_model & par_model, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_root_link_inertia=true);
 
+/** Constructs both a KDL tree and its KDL::CoDyCo tree serialization from a .par file, given the file name
+ *  Tree and serialization are built in a single pass, sharing the names of links and joints
+ * \param file The filename from where to read the .par file
+ * \param tree The resulting KDL Tree
+ * \param serialization The resulting KDL::CoDyCo TreeSerialization
+ * \param consider_root_link_inertia optional (default true) if true parse the first link
+ *                  of the robot model as a real link, and introduces a dummy link connected to it
+ *                 with a fixed joint to overcome the the fact that KDL does not support inertia in the first link
+ * returns true on success, false on failure
+ */
+bool treeAndSerializationFromSymoroParFile(const std::string& parfile_name, KDL::Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_root_link_inertia=true);
+
+/** Constructs both a KDL tree and its KDL::CoDyCo tree serialization from a string of the contents of the par file
+ * \param xml A string containting the Symoro+ par description of the robot
+ * \param tree The resulting KDL Tree
+ * \param serialization The resulting KDL::CoDyCo TreeSerialization
+ * \param consider_root_link_inertia see treeAndSerializationFromSymoroParFile
+ * returns true on success, false on failure
+ */
+bool treeAndSerializationFromSymoroParString(const std::string& parfile_content, KDL::Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_root_link_inertia=true);
+
+/** Constructs both a KDL tree and its KDL::CoDyCo tree serialization from a structure representation of the contents of the par file
+ * \param par_model A symoro_par_model object containing the Symoro+ par description of the robot (chain or tree)
+ * \param tree The resulting KDL Tree
+ * \param serialization The resulting KDL::CoDyCo TreeSerialization
+ * \param consider_root_link_inertia see treeAndSerializationFromSymoroParFile
+ * returns true on success, false on failure
+ */
+bool treeAndSerializationFromParModel(const symoro_par_model & par_model, KDL::Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_root_link_inertia=true);
+
 }
 
 #endif
@@ -41,31 +41,267 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <cstring>
+#include <algorithm>
 
 namespace kdl_format_io {
 
 /**
- * Class for representing the content of a SyMoRo PAR file (only geometric parameters for now)
+ * Entry of a per-link vector of a SyMoRo PAR file that is defined
+ * by a symbolic parameter (for example XX3) instead of a numerical value
+ */
+struct symoro_par_symbolic_entry
+{
+    int link;       ///< index (0 based) of the link
+    int field;      ///< field of the link (one of the symoro_par_model field enums)
+    int parameter;  ///< index of the parameter in the corresponding parameter names table
+};
+
+class symoro_par_model;
+
+/**
+ * Per-link field of a symoro_par_model (for example Ant or XX).
+ *
+ * The values are stored in the single allocation owned by the model: a field
+ * that grows beyond the links reserved in the model makes the model reserve
+ * more links, so all its fields are moved to a new allocation.
+ */
+template<typename T>
+class symoro_par_link_field
+{
+public:
+    symoro_par_link_field(): values(0), count(0), capacity(0), model(0) {}
+
+    int size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    T & operator[](const int l) { return values[l]; }
+
+    const T & operator[](const int l) const { return values[l]; }
+
+    T * begin() { return values; }
+
+    T * end() { return values+count; }
+
+    const T * begin() const { return values; }
+
+    const T * end() const { return values+count; }
+
+    operator std::vector<T>() const { return std::vector<T>(begin(),end()); }
+
+    /**
+     * Copy the values of another field (or of a std::vector), growing the model if needed
+     */
+    symoro_par_link_field & operator=(const symoro_par_link_field & other) { assign(other.begin(),other.end()); return *this; }
+
+    symoro_par_link_field & operator=(const std::vector<T> & other) { assign(other.empty() ? 0 : &other[0],other.empty() ? 0 : &other[0]+other.size()); return *this; }
+
+    /**
+     * Append a value, growing the model if the field is full.
+     * returns false only if the field does not belong to a model
+     */
+    bool push_back(const T & value);
+
+    /**
+     * Resize the field, new elements are set to zero, growing the model
+     * if it has less than n reserved links.
+     * returns false only if the field does not belong to a model
+     */
+    bool resize(const int n);
+
+private:
+    void assign(const T * begin, const T * end);
+
+    friend class symoro_par_model;
+
+    //The values are in the storage of the model, so a field can not be copied on its own
+    symoro_par_link_field(const symoro_par_link_field &);
+
+    T * values;
+    int count;
+    int capacity;
+    symoro_par_model * model;   ///< owner of the storage of the values
+};
+
+/**
+ * Class for representing the content of a SyMoRo PAR file (geometric and inertial parameters)
+ *
+ * All the per-link fields are stored in a single allocation, sized with reserveLinks()
+ * or grown by the fields when they need more links.
  */
 class symoro_par_model {
     
     
 private:
-    static std::string vector2string(const std::vector<int> & vec) 
+    template<typename T>
+    static std::string vector2string(const symoro_par_link_field<T> & vec)
     {
         std::stringstream ss;
         for(int l=0; l < vec.size(); l++ ) { ss << " " << vec[l]; }
         return ss.str();
     }
-    
-    static std::string vector2string(const std::vector<double> & vec) 
+
+    enum { NR_OF_DOUBLE_FIELDS = 16, NR_OF_INT_FIELDS = 3 };
+
+    char * storage;         ///< values of all the per-link fields, doubles followed by ints
+    int link_capacity;      ///< number of links for which the storage is allocated
+
+    static size_t storageSize(const int nr_of_links)
     {
-        std::stringstream ss;
-        for(int l=0; l < vec.size(); l++ ) { ss << " " << vec[l]; }
-        return ss.str();
+        return nr_of_links*(NR_OF_DOUBLE_FIELDS*sizeof(double)+NR_OF_INT_FIELDS*sizeof(int));
+    }
+
+    void fields(symoro_par_link_field<double> * doubles[NR_OF_DOUBLE_FIELDS], symoro_par_link_field<int> * ints[NR_OF_INT_FIELDS]) const
+    {
+        symoro_par_model & self = const_cast<symoro_par_model&>(*this);
+        symoro_par_link_field<double> * double_fields[NR_OF_DOUBLE_FIELDS] = {&self.B,&self.d,&self.R,&self.gamma,&self.Alpha,&self.Theta,
+                                                                              &self.XX,&self.XY,&self.XZ,&self.YY,&self.YZ,&self.ZZ,
+                                                                              &self.MX,&self.MY,&self.MZ,&self.M};
+        symoro_par_link_field<int> * int_fields[NR_OF_INT_FIELDS] = {&self.Ant,&self.Sigma,&self.Mu};
+        std::copy(double_fields,double_fields+NR_OF_DOUBLE_FIELDS,doubles);
+        std::copy(int_fields,int_fields+NR_OF_INT_FIELDS,ints);
+    }
+
+    /**
+     * Point the fields to their slice of the storage
+     */
+    void bindFields()
+    {
+        symoro_par_link_field<double> * doubles[NR_OF_DOUBLE_FIELDS];
+        symoro_par_link_field<int> * ints[NR_OF_INT_FIELDS];
+        fields(doubles,ints);
+        double * double_values = reinterpret_cast<double*>(storage);
+        int * int_values = reinterpret_cast<int*>(double_values+NR_OF_DOUBLE_FIELDS*link_capacity);
+        for(int f=0; f < NR_OF_DOUBLE_FIELDS; f++ ) {
+            doubles[f]->values = double_values+f*link_capacity;
+            doubles[f]->capacity = link_capacity;
+            doubles[f]->model = this;
+        }
+        for(int f=0; f < NR_OF_INT_FIELDS; f++ ) {
+            ints[f]->values = int_values+f*link_capacity;
+            ints[f]->capacity = link_capacity;
+            ints[f]->model = this;
+        }
+    }
+
+    /**
+     * Copy everything but the per-link fields
+     */
+    void copyScalars(const symoro_par_model & other)
+    {
+        name = other.name;
+        NF = other.NF;
+        NL = other.NL;
+        NJ = other.NJ;
+        Type = other.Type;
+        geometric_parameter_names = other.geometric_parameter_names;
+        geometric_entries = other.geometric_entries;
+        inertial_parameter_names = other.inertial_parameter_names;
+        inertial_entries = other.inertial_entries;
+    }
+
+    /**
+     * Exchange everything but the per-link fields
+     */
+    void swapScalars(symoro_par_model & other)
+    {
+        name.swap(other.name);
+        std::swap(NF,other.NF);
+        std::swap(NL,other.NL);
+        std::swap(NJ,other.NJ);
+        std::swap(Type,other.Type);
+        geometric_parameter_names.swap(other.geometric_parameter_names);
+        geometric_entries.swap(other.geometric_entries);
+        inertial_parameter_names.swap(other.inertial_parameter_names);
+        inertial_entries.swap(other.inertial_entries);
     }
     
 public:
+    symoro_par_model(): storage(0), link_capacity(0), NF(0), NL(0), NJ(0), Type(-1) { bindFields(); }
+
+    symoro_par_model(const symoro_par_model & other): storage(0), link_capacity(0)
+    {
+        bindFields();
+        *this = other;
+    }
+
+    ~symoro_par_model() { delete [] storage; }
+
+    /**
+     * The copy needs a single allocation for all the per-link fields
+     */
+    symoro_par_model & operator=(const symoro_par_model & other)
+    {
+        if( this == &other ) return *this;
+        if( link_capacity != other.link_capacity ) {
+            delete [] storage;
+            storage = other.link_capacity > 0 ? new char[storageSize(other.link_capacity)] : 0;
+            link_capacity = other.link_capacity;
+            bindFields();
+        }
+        if( link_capacity > 0 ) memcpy(storage,other.storage,storageSize(link_capacity));
+
+        symoro_par_link_field<double> * doubles[NR_OF_DOUBLE_FIELDS], * other_doubles[NR_OF_DOUBLE_FIELDS];
+        symoro_par_link_field<int> * ints[NR_OF_INT_FIELDS], * other_ints[NR_OF_INT_FIELDS];
+        fields(doubles,ints);
+        other.fields(other_doubles,other_ints);
+        for(int f=0; f < NR_OF_DOUBLE_FIELDS; f++ ) { doubles[f]->count = other_doubles[f]->count; }
+        for(int f=0; f < NR_OF_INT_FIELDS; f++ ) { ints[f]->count = other_ints[f]->count; }
+
+        copyScalars(other);
+        return *this;
+    }
+
+    /**
+     * Exchange the content of two models, without copying the per-link fields
+     */
+    void swap(symoro_par_model & other)
+    {
+        swapScalars(other);
+        std::swap(storage,other.storage);
+        std::swap(link_capacity,other.link_capacity);
+
+        symoro_par_link_field<double> * doubles[NR_OF_DOUBLE_FIELDS], * other_doubles[NR_OF_DOUBLE_FIELDS];
+        symoro_par_link_field<int> * ints[NR_OF_INT_FIELDS], * other_ints[NR_OF_INT_FIELDS];
+        fields(doubles,ints);
+        other.fields(other_doubles,other_ints);
+        for(int f=0; f < NR_OF_DOUBLE_FIELDS; f++ ) { std::swap(doubles[f]->count,other_doubles[f]->count); }
+        for(int f=0; f < NR_OF_INT_FIELDS; f++ ) { std::swap(ints[f]->count,other_ints[f]->count); }
+        bindFields();
+        other.bindFields();
+    }
+
+    /**
+     * Allocate the storage of the per-link fields for (at least) nr_of_links links,
+     * keeping their content. The fields are not resized.
+     */
+    void reserveLinks(const int nr_of_links)
+    {
+        if( nr_of_links <= link_capacity ) return;
+
+        symoro_par_link_field<double> * doubles[NR_OF_DOUBLE_FIELDS];
+        symoro_par_link_field<int> * ints[NR_OF_INT_FIELDS];
+        fields(doubles,ints);
+
+        char * old_storage = storage;
+        double * old_doubles[NR_OF_DOUBLE_FIELDS];
+        int * old_ints[NR_OF_INT_FIELDS];
+        for(int f=0; f < NR_OF_DOUBLE_FIELDS; f++ ) { old_doubles[f] = doubles[f]->values; }
+        for(int f=0; f < NR_OF_INT_FIELDS; f++ ) { old_ints[f] = ints[f]->values; }
+
+        storage = new char[storageSize(nr_of_links)];
+        memset(storage,0,storageSize(nr_of_links));
+        link_capacity = nr_of_links;
+        bindFields();
+
+        for(int f=0; f < NR_OF_DOUBLE_FIELDS; f++ ) { std::copy(old_doubles[f],old_doubles[f]+doubles[f]->count,doubles[f]->values); }
+        for(int f=0; f < NR_OF_INT_FIELDS; f++ ) { std::copy(old_ints[f],old_ints[f]+ints[f]->count,ints[f]->values); }
+        delete [] old_storage;
+    }
+
+    int getNrOfReservedLinks() const { return link_capacity; }
+
     std::string name;
 
     int NF;
@@ -73,16 +309,94 @@ public:
     int NJ;
     int Type;
         
-    std::vector<int> Ant;
-    std::vector<int> Sigma;
-    std::vector<double> B;
-    std::vector<double> d;
-    std::vector<double> R;
-    std::vector<double> gamma;
-    std::vector<double> Alpha;
-    std::vector<int> Mu;
-    std::vector<double> Theta;
-    
+    symoro_par_link_field<int> Ant;
+    symoro_par_link_field<int> Sigma;
+    symoro_par_link_field<double> B;
+    symoro_par_link_field<double> d;
+    symoro_par_link_field<double> R;
+    symoro_par_link_field<double> gamma;
+    symoro_par_link_field<double> Alpha;
+    symoro_par_link_field<int> Mu;
+    symoro_par_link_field<double> Theta;
+
+    enum geometric_field { B_FIELD, D_FIELD, R_FIELD, GAMMA_FIELD, ALPHA_FIELD,
+                           NR_OF_GEOMETRIC_FIELDS };
+
+    /**
+     * Names of the symbolic geometric parameters (the calibration parameters, for
+     * example D3 or RL4) and the entries of B, d, R, gamma and Alpha where they are used
+     */
+    std::vector<std::string> geometric_parameter_names;
+    std::vector<symoro_par_symbolic_entry> geometric_entries;
+
+    symoro_par_link_field<double> & geometricField(const int field)
+    {
+        symoro_par_link_field<double> * fields[NR_OF_GEOMETRIC_FIELDS] = {&B,&d,&R,&gamma,&Alpha};
+        return *fields[field];
+    }
+
+    const symoro_par_link_field<double> & geometricField(const int field) const
+    {
+        const symoro_par_link_field<double> * fields[NR_OF_GEOMETRIC_FIELDS] = {&B,&d,&R,&gamma,&Alpha};
+        return *fields[field];
+    }
+
+    static const char * geometricFieldName(const int field)
+    {
+        const char * names[NR_OF_GEOMETRIC_FIELDS] = {"B","d","R","gamma","Alpha"};
+        return names[field];
+    }
+
+    /**
+     * Inertial parameters, in the SyMoRo convention: the inertia (XX..ZZ) and the first
+     * moment of inertia (MX,MY,MZ) are expressed with respect to the link frame origin.
+     * Symbolic entries have value 0 until they are bound.
+     */
+    symoro_par_link_field<double> XX;
+    symoro_par_link_field<double> XY;
+    symoro_par_link_field<double> XZ;
+    symoro_par_link_field<double> YY;
+    symoro_par_link_field<double> YZ;
+    symoro_par_link_field<double> ZZ;
+    symoro_par_link_field<double> MX;
+    symoro_par_link_field<double> MY;
+    symoro_par_link_field<double> MZ;
+    symoro_par_link_field<double> M;
+
+    enum inertial_field { XX_FIELD, XY_FIELD, XZ_FIELD, YY_FIELD, YZ_FIELD,
+                          ZZ_FIELD, MX_FIELD, MY_FIELD, MZ_FIELD, M_FIELD,
+                          NR_OF_INERTIAL_FIELDS };
+
+    /**
+     * Names of the symbolic inertial parameters (the parameter slots)
+     * and the entries of the inertial vectors where they are used
+     */
+    std::vector<std::string> inertial_parameter_names;
+    std::vector<symoro_par_symbolic_entry> inertial_entries;
+
+    symoro_par_link_field<double> & inertialField(const int field)
+    {
+        symoro_par_link_field<double> * fields[NR_OF_INERTIAL_FIELDS] = {&XX,&XY,&XZ,&YY,&YZ,&ZZ,&MX,&MY,&MZ,&M};
+        return *fields[field];
+    }
+
+    const symoro_par_link_field<double> & inertialField(const int field) const
+    {
+        const symoro_par_link_field<double> * fields[NR_OF_INERTIAL_FIELDS] = {&XX,&XY,&XZ,&YY,&YZ,&ZZ,&MX,&MY,&MZ,&M};
+        return *fields[field];
+    }
+
+    static const char * inertialFieldName(const int field)
+    {
+        const char * names[NR_OF_INERTIAL_FIELDS] = {"XX","XY","XZ","YY","YZ","ZZ","MX","MY","MZ","M"};
+        return names[field];
+    }
+
+    /**
+     * True if the inertial parameters were specified in the PAR file
+     */
+    bool hasInertialParameters() const { return M.size() != 0; }
+
     std::string toString() const {
         std::stringstream ss;
         ss << "Robot name:\t" << name << std::endl;
@@ -99,6 +413,19 @@ public:
         ss << "Alpha\t" << vector2string(Alpha) << std::endl;
         ss << "Mu\t" << vector2string(Mu) << std::endl;
         ss << "Theta\t" << vector2string(Theta) << std::endl;
+        if( geometric_parameter_names.size() != 0 ) {
+            ss << "Geometric parameters\t";
+            for(int p=0; p < geometric_parameter_names.size(); p++ ) { ss << " " << geometric_parameter_names[p]; }
+            ss << std::endl;
+        }
+        if( hasInertialParameters() ) {
+            for(int f=0; f < NR_OF_INERTIAL_FIELDS; f++ ) {
+                ss << inertialFieldName(f) << "\t" << vector2string(inertialField(f)) << std::endl;
+            }
+            ss << "Inertial parameters\t";
+            for(int p=0; p < inertial_parameter_names.size(); p++ ) { ss << " " << inertial_parameter_names[p]; }
+            ss << std::endl;
+        }
         return ss.str();
     }
     
@@ -117,10 +444,68 @@ public:
                 NL != d.size()   || NL != R.size()     || NL != gamma.size() || NL != Alpha.size() || NL != Theta.size() ) return false;
         } else if ( Type == 2 ) {
         }
+
+        for(int e=0; e < geometric_entries.size(); e++ ) {
+            if( geometric_entries[e].link < 0 || geometric_entries[e].link >= NL ||
+                geometric_entries[e].parameter < 0 || geometric_entries[e].parameter >= geometric_parameter_names.size() ) return false;
+        }
+
+        //If present, the inertial parameters are specified for each link
+        if( hasInertialParameters() ) {
+            for(int f=0; f < NR_OF_INERTIAL_FIELDS; f++ ) {
+                if( NL != inertialField(f).size() ) return false;
+            }
+            for(int e=0; e < inertial_entries.size(); e++ ) {
+                if( inertial_entries[e].link < 0 || inertial_entries[e].link >= NL ||
+                    inertial_entries[e].parameter < 0 || inertial_entries[e].parameter >= inertial_parameter_names.size() ) return false;
+            }
+        }
         
         return true;
     }
 };
+
+template<typename T>
+bool symoro_par_link_field<T>::push_back(const T & value)
+{
+    if( count == capacity ) {
+        if( !model ) return false;
+        model->reserveLinks(capacity > 0 ? 2*capacity : 1);
+    }
+    values[count] = value;
+    count++;
+    return true;
+}
+
+template<typename T>
+bool symoro_par_link_field<T>::resize(const int n)
+{
+    if( n > capacity ) {
+        if( !model ) return false;
+        model->reserveLinks(std::max(n,2*capacity));
+    }
+    for(int l=count; l < n; l++ ) { values[l] = T(); }
+    count = n;
+    return true;
+}
+
+template<typename T>
+void symoro_par_link_field<T>::assign(const T * begin, const T * end)
+{
+    const int n = end-begin;
+    if( begin == values ) { resize(n); return; }
+    if( n <= capacity ) {
+        std::copy(begin,end,values);
+        count = n;
+        return;
+    }
+    //Growing the model moves its storage, that can contain the values to copy,
+    //so only in this case they are saved first
+    std::vector<T> copy(begin,end);
+    if( !resize(n) ) return;
+    std::copy(copy.begin(),copy.end(),values);
+}
+
 }
 
 #endif
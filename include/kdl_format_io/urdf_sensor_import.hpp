@@ -44,6 +44,10 @@
 
 class TiXmlDocument;
 
+namespace KDL {
+    class Tree;
+}
+
 
 
 namespace kdl_format_io{
@@ -62,9 +66,78 @@ struct FTSensorData
 };
 
 
+/**
+ * Sensors of a given type found in a URDF, stored as contiguous columns:
+ * element i of each vector refers to the i-th sensor of the type
+ */
+struct SensorTable
+{
+    std::vector<std::string> names;           ///< name of the sensor
+    std::vector<std::string> parent_names;    ///< reference of the sensor (a joint for the force_torque sensors, a link otherwise)
+    std::vector<int> parent_indices;          ///< index of the parent in SensorTables::joint_names or SensorTables::link_names, -1 if not found
+    std::vector<KDL::Frame> poses;            ///< pose of the sensor (the pose tag), identity if not specified
+
+    size_t size() const { return names.size(); }
+    void clear();
+};
+
+/**
+ * All the sensors of a URDF, in a table for each supported type.
+ *
+ * The sensors are read from the SDF extension of the URDF, as in
+ * <gazebo reference="r_arm_ft_joint"> <sensor name="r_arm_ft" type="force_torque"> ... </sensor> </gazebo>
+ */
+struct SensorTables
+{
+    enum SensorType { FORCE_TORQUE,
+                      IMU,
+                      ACCELEROMETER,
+                      GYROSCOPE,
+                      NR_OF_SENSOR_TYPES };
+
+    std::vector<std::string> link_names;    ///< links of the robot, in the order of the document
+    std::vector<std::string> joint_names;   ///< joints of the robot, in the order of the document
+
+    SensorTable tables[NR_OF_SENSOR_TYPES]; ///< tables[type] contains the sensors of that type
+
+    //Columns specific to the force_torque sensors, parallel to tables[FORCE_TORQUE]
+    std::vector<int> ft_frames;               ///< values of FTSensorData::frame
+    std::vector<int> ft_measure_directions;   ///< values of FTSensorData::measure_direction
+
+    /**
+     * Value of the type attribute of the sensor tag for a SensorType
+     * (force_torque, imu, accelerometer, gyroscope)
+     */
+    static const char * sensorTypeName(const int type);
+
+    /**
+     * true if the parent of the sensors of the type is a joint, false if it is a link
+     */
+    static bool isJointSensorType(const int type);
+
+    void clear();
+};
+
 bool ftSensorsFromUrdfFile(const std::string& file, std::vector<FTSensorData> & ft_sensors);
 bool ftSensorsFromUrdfString(const std::string& urdf_xml, std::vector<FTSensorData> & ft_sensors);
 
+/** Extracts all the supported sensors of a URDF in a single traversal of the document
+ * \param urdf_xml the parsed URDF, it can be shared with other readers of the same document
+ * \param sensors the resulting tables of sensors, one for each sensor type
+ * returns true on success, false on failure
+ */
+bool sensorsFromUrdfXml(const TiXmlDocument & urdf_xml, SensorTables & sensors);
+
+bool sensorsFromUrdfFile(const std::string& file, SensorTables & sensors);
+bool sensorsFromUrdfString(const std::string& urdf_xml, SensorTables & sensors);
+
+/** Constructs a KDL tree and extracts the sensors from the same URDF string, reading the file only once
+ * \param consider_root_link_inertia as in treeFromUrdfString
+ * returns true on success, false on failure
+ */
+bool treeAndSensorsFromUrdfFile(const std::string& file, KDL::Tree& tree, SensorTables & sensors, const bool consider_root_link_inertia=false);
+bool treeAndSensorsFromUrdfString(const std::string& urdf_xml, KDL::Tree& tree, SensorTables & sensors, const bool consider_root_link_inertia=false);
+
 }
 
 #endif
@@ -0,0 +1,562 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/cpp_kinematics_export.hpp"
+
+#include <kdl/tree.hpp>
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+using namespace KDL;
+using namespace std;
+
+namespace kdl_format_io {
+
+/**
+ * Kinematic description of a link used by the generator: the pose of the link with respect
+ * to its parent is pre*Rot(z,theta+q)*Trans(z,r)*post for revolute joints,
+ * pre*Rot(z,theta)*Trans(z,r+q)*post for prismatic joints and pre for fixed joints.
+ */
+struct cpp_kinematics_link
+{
+    std::string name;
+    int parent;     ///< index of the parent link, -1 for the base
+    int type;       ///< 0 revolute, 1 prismatic, 2 fixed (as SyMoRo Sigma)
+    int dof;        ///< index of the joint value, -1 for fixed joints
+    Frame pre;
+    double theta;
+    double r;
+    Frame post;
+};
+
+/**
+ * Value of a generated expression: either a constant known at generation time
+ * (that is folded) or a C++ expression
+ */
+struct cpp_term
+{
+    bool constant;
+    double value;
+    std::string expr;
+    bool compound;  ///< true if expr has to be enclosed in parentheses when used as a factor
+};
+
+static const double cpp_term_folding_tolerance = 1e-14;
+
+static cpp_term constant_term(double value)
+{
+    if( fabs(value) < cpp_term_folding_tolerance ) value = 0.0;
+    if( fabs(value-1.0) < cpp_term_folding_tolerance ) value = 1.0;
+    if( fabs(value+1.0) < cpp_term_folding_tolerance ) value = -1.0;
+    cpp_term t;
+    t.constant = true;
+    t.value = value;
+    t.compound = false;
+    return t;
+}
+
+static cpp_term expression_term(const std::string & expr, const bool compound=false)
+{
+    cpp_term t;
+    t.constant = false;
+    t.value = 0.0;
+    t.expr = expr;
+    t.compound = compound;
+    return t;
+}
+
+static std::string double2string(const double value)
+{
+    char buf[32];
+    sprintf(buf,"%.17g",value);
+    std::string ret(buf);
+    if( ret.find_first_of(".eEn") == std::string::npos ) ret += ".0";
+    return ret;
+}
+
+static std::string code(const cpp_term & t)
+{
+    return t.constant ? double2string(t.value) : t.expr;
+}
+
+static std::string factor(const cpp_term & t)
+{
+    if( t.constant ) return t.value < 0 ? "(" + double2string(t.value) + ")" : double2string(t.value);
+    return t.compound ? "(" + t.expr + ")" : t.expr;
+}
+
+static bool is_zero(const cpp_term & t) { return t.constant && t.value == 0.0; }
+
+static cpp_term neg(const cpp_term & a)
+{
+    if( a.constant ) return constant_term(-a.value);
+    return expression_term("-" + factor(a),true);
+}
+
+static cpp_term mul(const cpp_term & a, const cpp_term & b)
+{
+    if( a.constant && b.constant ) return constant_term(a.value*b.value);
+    if( is_zero(a) || is_zero(b) ) return constant_term(0.0);
+    if( a.constant && a.value == 1.0 ) return b;
+    if( b.constant && b.value == 1.0 ) return a;
+    if( a.constant && a.value == -1.0 ) return neg(b);
+    if( b.constant && b.value == -1.0 ) return neg(a);
+    if( b.constant ) return expression_term(factor(b) + "*" + factor(a));
+    return expression_term(factor(a) + "*" + factor(b));
+}
+
+static cpp_term add(const cpp_term & a, const cpp_term & b)
+{
+    if( a.constant && b.constant ) return constant_term(a.value+b.value);
+    if( is_zero(a) ) return b;
+    if( is_zero(b) ) return a;
+    if( b.constant && b.value < 0 ) return expression_term(code(a) + " - " + double2string(-b.value),true);
+    return expression_term(code(a) + " + " + factor(b),true);
+}
+
+static cpp_term sub(const cpp_term & a, const cpp_term & b)
+{
+    return add(a,neg(b));
+}
+
+struct cpp_term_frame
+{
+    cpp_term M[3][3];
+    cpp_term p[3];
+};
+
+static cpp_term_frame constant_frame(const Frame & f)
+{
+    cpp_term_frame ret;
+    for(int i=0; i < 3; i++ ) {
+        for(int j=0; j < 3; j++ ) {
+            ret.M[i][j] = constant_term(f.M(i,j));
+        }
+        ret.p[i] = constant_term(f.p(i));
+    }
+    return ret;
+}
+
+static cpp_term_frame compose(const cpp_term_frame & a, const cpp_term_frame & b)
+{
+    cpp_term_frame ret;
+    for(int i=0; i < 3; i++ ) {
+        for(int j=0; j < 3; j++ ) {
+            ret.M[i][j] = constant_term(0.0);
+            for(int k=0; k < 3; k++ ) {
+                ret.M[i][j] = add(ret.M[i][j],mul(a.M[i][k],b.M[k][j]));
+            }
+        }
+        ret.p[i] = a.p[i];
+        for(int k=0; k < 3; k++ ) {
+            ret.p[i] = add(ret.p[i],mul(a.M[i][k],b.p[k]));
+        }
+    }
+    return ret;
+}
+
+/**
+ * Frame with the z axis along axis, used to express a joint moving along an arbitrary axis
+ * as a joint moving along z. The frame is exactly a permutation for coordinate axes.
+ */
+static Rotation frame_with_z_axis(const Vector & axis)
+{
+    Vector z = axis/axis.Norm();
+    Vector v = fabs(z(0)) < 0.9 ? Vector(1,0,0) : Vector(0,1,0);
+    Vector x = v - z*dot(z,v);
+    x = x/x.Norm();
+    Vector y = z*x;
+    return Rotation(x(0),y(0),z(0),
+                    x(1),y(1),z(1),
+                    x(2),y(2),z(2));
+}
+
+static Frame z_screw(const double theta, const double r)
+{
+    return Frame(Rotation::RotZ(theta),Vector(0,0,r));
+}
+
+static bool is_valid_identifier(const std::string & name)
+{
+    if( name.empty() ) return false;
+    for(size_t i=0; i < name.size(); i++ ) {
+        char c = name[i];
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        if( !alpha && (i == 0 || c < '0' || c > '9') ) return false;
+    }
+    return true;
+}
+
+/**
+ * Emits the straight-line code, naming every non trivial intermediate value
+ */
+class cpp_kinematics_generator
+{
+public:
+    std::stringstream body;
+    std::string indent;
+
+    cpp_kinematics_generator(): indent("    ") {}
+
+    cpp_term assign(const std::string & name, const cpp_term & t)
+    {
+        if( t.constant || is_variable(t.expr) ) return t;
+        body << indent << "const double " << name << " = " << t.expr << ";" << std::endl;
+        return expression_term(name);
+    }
+
+    cpp_term_frame assign(const std::string & name, const cpp_term_frame & f)
+    {
+        cpp_term_frame ret;
+        for(int i=0; i < 3; i++ ) {
+            for(int j=0; j < 3; j++ ) {
+                std::stringstream ss;
+                ss << name << "_R" << i << j;
+                ret.M[i][j] = assign(ss.str(),f.M[i][j]);
+            }
+            std::stringstream ss;
+            ss << name << "_p" << i;
+            ret.p[i] = assign(ss.str(),f.p[i]);
+        }
+        return ret;
+    }
+
+    void output(const std::string & array, const int index, const cpp_term & t)
+    {
+        body << indent << array << "[" << index << "] = " << code(t) << ";" << std::endl;
+    }
+
+private:
+    static bool is_variable(const std::string & expr)
+    {
+        return expr.find_first_of(" +-*(") == std::string::npos;
+    }
+};
+
+static bool generateCppKinematics(const std::vector<cpp_kinematics_link> & links, const int nr_of_dofs,
+                                  const std::string & function_name, std::string & generated_code)
+{
+    if( !is_valid_identifier(function_name) ) {
+        std::cerr << "Error: " << function_name << " is not a valid name for a C++ function" << std::endl;
+        return false;
+    }
+
+    int nr_of_links = links.size();
+    cpp_kinematics_generator gen;
+    std::vector<cpp_term_frame> joint_frames(nr_of_links);
+    std::vector<cpp_term_frame> poses(nr_of_links);
+
+    for(int l=0; l < nr_of_links; l++ ) {
+        const cpp_kinematics_link & link = links[l];
+        gen.body << gen.indent << "// " << link.name << std::endl;
+
+        cpp_term_frame W = constant_frame(link.pre);
+        if( link.parent >= 0 ) W = compose(poses[link.parent],W);
+
+        cpp_term_frame L;
+        if( link.type == 2 ) {
+            L = W;
+        } else {
+            std::stringstream wname, qname;
+            wname << "W" << l;
+            qname << "q[" << link.dof << "]";
+            W = gen.assign(wname.str(),W);
+            joint_frames[l] = W;
+
+            cpp_term c, s, r;
+            if( link.type == 0 ) {
+                std::string angle = link.theta == 0.0 ? qname.str() : qname.str() + " + " + factor(constant_term(link.theta));
+                std::stringstream cname, sname;
+                cname << "c" << l;
+                sname << "s" << l;
+                c = gen.assign(cname.str(),expression_term("std::cos(" + angle + ")"));
+                s = gen.assign(sname.str(),expression_term("std::sin(" + angle + ")"));
+                r = constant_term(link.r);
+            } else {
+                c = constant_term(cos(link.theta));
+                s = constant_term(sin(link.theta));
+                r = add(expression_term(qname.str()),constant_term(link.r));
+            }
+
+            //W*Rot(z,theta)*Trans(z,r)
+            cpp_term_frame S;
+            for(int i=0; i < 3; i++ ) {
+                S.M[i][0] = add(mul(c,W.M[i][0]),mul(s,W.M[i][1]));
+                S.M[i][1] = add(mul(neg(s),W.M[i][0]),mul(c,W.M[i][1]));
+                S.M[i][2] = W.M[i][2];
+                S.p[i] = add(W.p[i],mul(r,W.M[i][2]));
+            }
+            L = compose(S,constant_frame(link.post));
+        }
+
+        std::stringstream tname;
+        tname << "T" << l;
+        poses[l] = gen.assign(tname.str(),L);
+
+        for(int i=0; i < 3; i++ ) {
+            for(int j=0; j < 3; j++ ) {
+                gen.output("poses",12*l+3*i+j,poses[l].M[i][j]);
+            }
+        }
+        for(int i=0; i < 3; i++ ) {
+            gen.output("poses",12*l+9+i,poses[l].p[i]);
+        }
+    }
+
+    if( nr_of_dofs > 0 ) {
+        gen.body << std::endl;
+        gen.body << gen.indent << "if( !jacobians ) return;" << std::endl;
+        gen.body << gen.indent << "for(int i=0; i < " << 6*nr_of_dofs*nr_of_links << "; i++ ) { jacobians[i] = 0.0; }" << std::endl;
+
+        for(int l=0; l < nr_of_links; l++ ) {
+            gen.body << gen.indent << "// Jacobian of " << links[l].name << std::endl;
+            for(int j=l; j >= 0; j = links[j].parent ) {
+                if( links[j].type == 2 ) continue;
+                int col = 6*(nr_of_dofs*l+links[j].dof);
+                cpp_term z[3], v[3];
+                for(int i=0; i < 3; i++ ) { z[i] = joint_frames[j].M[i][2]; }
+                if( links[j].type == 0 ) {
+                    //Linear velocity: z x (p_link - p_joint), angular velocity: z
+                    //d[i] is named only if it is multiplied by a nonzero component of z
+                    cpp_term d[3];
+                    for(int i=0; i < 3; i++ ) {
+                        d[i] = sub(poses[l].p[i],joint_frames[j].p[i]);
+                        if( !is_zero(z[(i+1)%3]) || !is_zero(z[(i+2)%3]) ) {
+                            std::stringstream dname;
+                            dname << "d" << l << "_" << j << "_" << i;
+                            d[i] = gen.assign(dname.str(),d[i]);
+                        }
+                    }
+                    v[0] = sub(mul(z[1],d[2]),mul(z[2],d[1]));
+                    v[1] = sub(mul(z[2],d[0]),mul(z[0],d[2]));
+                    v[2] = sub(mul(z[0],d[1]),mul(z[1],d[0]));
+                    for(int i=0; i < 3; i++ ) {
+                        if( !is_zero(v[i]) ) gen.output("jacobians",col+i,v[i]);
+                    }
+                    for(int i=0; i < 3; i++ ) {
+                        if( !is_zero(z[i]) ) gen.output("jacobians",col+3+i,z[i]);
+                    }
+                } else {
+                    for(int i=0; i < 3; i++ ) {
+                        if( !is_zero(z[i]) ) gen.output("jacobians",col+i,z[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    std::stringstream out;
+    out << "// Forward kinematics and Jacobians generated by kdl_format_io, do not edit" << std::endl;
+    out << std::endl;
+    out << "#include <cmath>" << std::endl;
+    out << std::endl;
+    out << "extern const int " << function_name << "_nr_of_dofs = " << nr_of_dofs << ";" << std::endl;
+    out << "extern const int " << function_name << "_nr_of_links = " << nr_of_links << ";" << std::endl;
+    if( nr_of_links > 0 ) {
+        out << "extern const char * const " << function_name << "_link_names[" << nr_of_links << "] = {";
+        for(int l=0; l < nr_of_links; l++ ) { out << (l == 0 ? "" : ", ") << "\"" << links[l].name << "\""; }
+        out << "};" << std::endl;
+    }
+    out << std::endl;
+    out << "/**" << std::endl;
+    out << " * Computes the pose and the Jacobian of each link, with respect to the base" << std::endl;
+    out << " * \\param q the " << nr_of_dofs << " joint values" << std::endl;
+    out << " * \\param poses " << 12*nr_of_links << " values: for each link the rotation matrix (row major) followed by the origin" << std::endl;
+    out << " * \\param jacobians NULL or " << 6*nr_of_dofs*nr_of_links << " values: for each link the 6x" << nr_of_dofs
+        << " Jacobian (column major)," << std::endl;
+    out << " *                  linear velocity of the link origin followed by angular velocity, expressed in the base frame" << std::endl;
+    out << " */" << std::endl;
+    out << "void " << function_name << "(const double * q, double * poses, double * jacobians)" << std::endl;
+    out << "{" << std::endl;
+    if( nr_of_dofs == 0 ) out << "    (void)q;" << std::endl << "    (void)jacobians;" << std::endl;
+    out << gen.body.str();
+    out << "}" << std::endl;
+
+    generated_code = out.str();
+    return true;
+}
+
+static bool writeCode(const std::string & file, const std::string & code)
+{
+    std::ofstream ofs(file.c_str());
+    if( !ofs.is_open() ) {
+        std::cerr << "Error: could not open file " << file << std::endl;
+        return false;
+    }
+    ofs << code;
+    return ofs.good();
+}
+
+static void addTreeLinks(const Tree & tree, const SegmentMap::const_iterator & element, const int parent,
+                         std::vector<cpp_kinematics_link> & links, bool & ok)
+{
+    for(size_t c=0; c < element->second.children.size(); c++ ) {
+        SegmentMap::const_iterator child = element->second.children[c];
+        const Segment & segment = child->second.segment;
+        const Joint & joint = segment.getJoint();
+
+        cpp_kinematics_link link;
+        link.name = segment.getName();
+        link.parent = parent;
+        link.theta = 0.0;
+        link.r = 0.0;
+
+        switch( joint.getType() ) {
+            case Joint::None:
+                link.type = 2;
+            break;
+            case Joint::RotAxis:
+            case Joint::RotX:
+            case Joint::RotY:
+            case Joint::RotZ:
+                link.type = 0;
+            break;
+            case Joint::TransAxis:
+            case Joint::TransX:
+            case Joint::TransY:
+            case Joint::TransZ:
+                link.type = 1;
+            break;
+            default:
+                std::cerr << "Error: joint " << joint.getName() << " has a type not supported by the C++ kinematics generator" << std::endl;
+                ok = false;
+                return;
+            break;
+        }
+
+        if( link.type == 2 ) {
+            link.dof = -1;
+            link.pre = segment.pose(0.0);
+            link.post = Frame::Identity();
+        } else {
+            //pose(q) = Trans(origin)*Rot(axis,q)*Trans(-origin)*pose(0) for revolute joints
+            //and Trans(axis*q)*pose(0) for prismatic joints, that is pre*Rot(z,q)*pre^-1*pose(0)
+            //and pre*Trans(z,q)*pre^-1*pose(0) with pre having the z axis along the joint axis
+            link.dof = child->second.q_nr;
+            link.pre = Frame(frame_with_z_axis(joint.JointAxis()),joint.JointOrigin());
+            link.post = link.pre.Inverse()*segment.pose(0.0);
+
+            double q_test = 0.5;
+            Frame expected = link.type == 0 ? link.pre*z_screw(q_test,0)*link.post : link.pre*z_screw(0,q_test)*link.post;
+            if( !Equal(expected,segment.pose(q_test),1e-9) ) {
+                std::cerr << "Error: joint " << joint.getName() << " has a scale not supported by the C++ kinematics generator" << std::endl;
+                ok = false;
+                return;
+            }
+        }
+
+        links.push_back(link);
+        addTreeLinks(tree,child,links.size()-1,links,ok);
+        if( !ok ) return;
+    }
+}
+
+bool treeToCppKinematicsString(const Tree& tree, const std::string& function_name, std::string& code)
+{
+    std::vector<cpp_kinematics_link> links;
+    bool ok = true;
+    addTreeLinks(tree,tree.getRootSegment(),-1,links,ok);
+    if( !ok ) return false;
+
+    return generateCppKinematics(links,tree.getNrOfJoints(),function_name,code);
+}
+
+bool treeToCppKinematicsFile(const std::string& file, const Tree& tree, const std::string& function_name)
+{
+    std::string code;
+    if( !treeToCppKinematicsString(tree,function_name,code) ) return false;
+    return writeCode(file,code);
+}
+
+bool parModelToCppKinematicsString(const symoro_par_model& par_model, const std::string& function_name, std::string& code)
+{
+    if( (par_model.Type != 0 && par_model.Type != 1) || !par_model.isConsistent() ) {
+        std::cerr << "Error: the C++ kinematics generator supports only consistent SYMORO+ models of Type Tree (1) and Simple Chain (0)" << std::endl;
+        return false;
+    }
+
+    std::vector<cpp_kinematics_link> links(par_model.NL);
+    int nr_of_dofs = 0;
+    for(int l=0; l < par_model.NL; l++ ) {
+        cpp_kinematics_link & link = links[l];
+        std::stringstream ss;
+        ss << "Link" << l+1;
+        link.name = ss.str();
+
+        if( par_model.Ant[l] < 0 || par_model.Ant[l] > l ) {
+            std::cerr << "Error: link " << l+1 << " has parent " << par_model.Ant[l] << ", that does not precede it" << std::endl;
+            return false;
+        }
+        link.parent = par_model.Ant[l]-1;
+
+        link.type = par_model.Sigma[l];
+        if( link.type < 0 || link.type > 2 ) {
+            std::cerr << "Error: Sigma value not expected"<< std::endl;
+            return false;
+        }
+
+        //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r), see DH_Khalil1986_Tree
+        link.pre = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
+                   Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0));
+        link.theta = par_model.Theta[l];
+        link.r = par_model.R[l];
+        link.post = Frame::Identity();
+
+        if( link.type == 2 ) {
+            link.dof = -1;
+            link.pre = link.pre*z_screw(link.theta,link.r);
+        } else {
+            link.dof = nr_of_dofs++;
+        }
+    }
+
+    return generateCppKinematics(links,nr_of_dofs,function_name,code);
+}
+
+bool parModelToCppKinematicsFile(const std::string& file, const symoro_par_model& par_model, const std::string& function_name)
+{
+    std::string code;
+    if( !parModelToCppKinematicsString(par_model,function_name,code) ) return false;
+    return writeCode(file,code);
+}
+
+}
@@ -0,0 +1,196 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "numeric_scanner.hpp"
+
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include <string>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+namespace kdl_format_io {
+
+static inline char charAt(const char * p, const char * end)
+{
+    return (end == 0 || p < end) ? *p : '\0';
+}
+
+static inline bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Parse the number in [begin,end) with strtod in the C locale, that is
+ * created once and does not depend on the locale of the process, so the
+ * scanner is thread-safe. Used only for the numbers that can not be
+ * converted exactly by scanDouble
+ */
+static double slowStrtod(const char * begin, const char * end)
+{
+    char buffer[64];
+    std::string long_buffer;
+    char * text = buffer;
+    size_t len = end-begin;
+    if( len >= sizeof(buffer) ) {
+        long_buffer.resize(len+1);
+        text = &long_buffer[0];
+    }
+    std::copy(begin,end,text);
+    text[len] = '\0';
+#ifdef _WIN32
+    static const _locale_t c_locale = _create_locale(LC_NUMERIC,"C");
+    return _strtod_l(text,0,c_locale);
+#else
+    static const locale_t c_locale = newlocale(LC_NUMERIC_MASK,"C",(locale_t)0);
+    return strtod_l(text,0,c_locale);
+#endif
+}
+
+const char * scanDouble(const char * begin, const char * end, double & value)
+{
+    //Powers of ten that are exactly represented by a double
+    static const double powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const int max_exact_power = 22;
+    const int max_nr_of_digits = 19;
+
+    const char * p = begin;
+    bool negative = false;
+    if( charAt(p,end) == '-' || charAt(p,end) == '+' ) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    //The significant digits (at most 19, that fit in 64 bits) are accumulated in mantissa,
+    //the value is mantissa*10^exponent
+    unsigned long long mantissa = 0;
+    int nr_of_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool truncated = false;
+
+    for(; isDigit(charAt(p,end)); p++ ) {
+        has_digits = true;
+        if( nr_of_digits < max_nr_of_digits ) {
+            mantissa = 10*mantissa + (*p-'0');
+            if( mantissa != 0 ) nr_of_digits++;
+        } else {
+            exponent++;
+            truncated = truncated || *p != '0';
+        }
+    }
+    if( charAt(p,end) == '.' ) {
+        p++;
+        for(; isDigit(charAt(p,end)); p++ ) {
+            has_digits = true;
+            if( nr_of_digits < max_nr_of_digits ) {
+                mantissa = 10*mantissa + (*p-'0');
+                if( mantissa != 0 ) nr_of_digits++;
+                exponent--;
+            } else {
+                truncated = truncated || *p != '0';
+            }
+        }
+    }
+
+    if( !has_digits ) {
+        value = 0;
+        return begin;
+    }
+
+    //The exponent is consumed only if it has at least a digit
+    char e = charAt(p,end);
+    if( e == 'e' || e == 'E' ) {
+        const char * q = p+1;
+        bool negative_exponent = false;
+        if( charAt(q,end) == '-' || charAt(q,end) == '+' ) {
+            negative_exponent = (*q == '-');
+            q++;
+        }
+        if( isDigit(charAt(q,end)) ) {
+            int explicit_exponent = 0;
+            for(; isDigit(charAt(q,end)); q++ ) {
+                if( explicit_exponent < 100000 ) explicit_exponent = 10*explicit_exponent + (*q-'0');
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+            p = q;
+        }
+    }
+
+    //Fast path (Clinger): the mantissa and the power of ten are exact doubles, so
+    //a single multiplication or division gives the correctly rounded result
+    const unsigned long long max_exact_mantissa = 1ULL << 53;
+    if( mantissa == 0 ) {
+        value = negative ? -0.0 : 0.0;
+    } else if( !truncated && mantissa <= max_exact_mantissa && exponent >= -max_exact_power && exponent <= max_exact_power ) {
+        double result = (double)mantissa;
+        result = exponent < 0 ? result/powers_of_ten[-exponent] : result*powers_of_ten[exponent];
+        value = negative ? -result : result;
+    } else {
+        value = slowStrtod(begin,p);
+    }
+
+    return p;
+}
+
+const char * scanInt(const char * begin, const char * end, int & value)
+{
+    const char * p = begin;
+    bool negative = false;
+    if( charAt(p,end) == '-' || charAt(p,end) == '+' ) {
+        negative = (*p == '-');
+        p++;
+    }
+    if( !isDigit(charAt(p,end)) ) return begin;
+
+    long long val = 0;
+    for(; isDigit(charAt(p,end)); p++ ) {
+        val = 10*val + (*p-'0');
+        if( val > (long long)INT_MAX+1 ) return begin;
+    }
+    if( negative ) val = -val;
+    if( val > INT_MAX || val < INT_MIN ) return begin;
+
+    value = (int)val;
+    return p;
+}
+
+}
@@ -0,0 +1,66 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef NUMERIC_SCANNER_H
+#define NUMERIC_SCANNER_H
+
+namespace kdl_format_io {
+
+/**
+ * Scanner of the numbers in the text formats (.par files, expressions, URDF poses).
+ *
+ * The numbers are always read with the '.' decimal separator, whatever the locale
+ * of the process, and without allocations or copies of the text. The scanned
+ * characters are in [begin,end), or up to the terminating '\0' if end is NULL.
+ */
+
+/**
+ * Scan a decimal floating point number, as 12, -0.5, .25 or 2.3e-4, at begin.
+ * The result is correctly rounded, as the one of strtod in the C locale.
+ * returns the first character after the number, or begin (with value set to 0) if there is no number
+ */
+const char * scanDouble(const char * begin, const char * end, double & value);
+
+/**
+ * Scan a decimal integer, with an optional sign, at begin
+ * returns the first character after the integer, or begin if there is no integer
+ * or if it does not fit in an int
+ */
+const char * scanInt(const char * begin, const char * end, int & value);
+
+}
+
+#endif
@@ -0,0 +1,504 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/symoro_code_evaluator.hpp"
+#include "numeric_scanner.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace kdl_format_io {
+
+static inline bool is_blank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool is_name_start(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline const char * skip_blanks(const char * p)
+{
+    while( is_blank(*p) ) p++;
+    return p;
+}
+
+/**
+ * Parse a name, including member accesses and array subscripts (base_vel.rot[0])
+ */
+static bool parse_name(const char * & p, std::string & name)
+{
+    if( !is_name_start(*p) ) return false;
+    const char * begin = p;
+    while( is_name_start(*p) || is_digit(*p) || *p == '.' || *p == '[' ) {
+        if( *p == '[' ) {
+            while( *p && *p != ']' ) p++;
+            if( !*p ) return false;
+        }
+        p++;
+    }
+    name.assign(begin,p);
+    return true;
+}
+
+static bool parse_int(const char * & p, int & value)
+{
+    p = skip_blanks(p);
+    const char * end = scanInt(p,0,value);
+    if( end == p ) return false;
+    p = skip_blanks(end);
+    return true;
+}
+
+/**
+ * Parse a list of one or two integer indices between parentheses, as in (0,10)
+ */
+static bool parse_indices(const char * & p, int & row, int & col)
+{
+    const char * q = p;
+    col = 0;
+    if( *q != '(' ) return false;
+    q++;
+    if( !parse_int(q,row) ) return false;
+    if( *q == ',' ) {
+        q++;
+        if( !parse_int(q,col) ) return false;
+    }
+    if( *q != ')' ) return false;
+    p = q+1;
+    return true;
+}
+
+bool symoro_code_evaluator::node::operator<(const node & other) const
+{
+    if( op != other.op ) return op < other.op;
+    if( a != other.a ) return a < other.a;
+    if( b != other.b ) return b < other.b;
+    return value < other.value;
+}
+
+double symoro_code_evaluator::apply(const int op, const double a, const double b)
+{
+    switch( op ) {
+        case NEG: return -a;
+        case ADD: return a+b;
+        case SUB: return a-b;
+        case MUL: return a*b;
+        case DIV: return a/b;
+        case POW: return pow(a,b);
+        case ATAN2: return atan2(a,b);
+        case SIN: return sin(a);
+        case COS: return cos(a);
+        case TAN: return tan(a);
+        case ASIN: return asin(a);
+        case ACOS: return acos(a);
+        case ATAN: return atan(a);
+        case SQRT: return sqrt(a);
+        case EXP: return exp(a);
+        case LOG: return log(a);
+        case ABS: return fabs(a);
+        case SIGN: return a < 0.0 ? -1.0 : (a == 0.0 ? 0.0 : 1.0);
+    }
+    return 0.0;
+}
+
+symoro_code_evaluator::symoro_code_evaluator()
+{
+}
+
+void symoro_code_evaluator::clear()
+{
+    nodes.clear();
+    unique_nodes.clear();
+    variables.clear();
+    input_names.clear();
+    input_nodes.clear();
+    outputs.clear();
+    program.clear();
+    values.clear();
+}
+
+int symoro_code_evaluator::addConstant(const double value)
+{
+    return addNode(CONSTANT,-1,-1,value);
+}
+
+int symoro_code_evaluator::addNode(const int op, int a, int b, const double value)
+{
+    if( op != CONSTANT && op != INPUT ) {
+        //Constant folding
+        bool a_const = nodes[a].op == CONSTANT;
+        bool b_const = b < 0 || nodes[b].op == CONSTANT;
+        if( a_const && b_const ) {
+            return addConstant(apply(op,nodes[a].value,b < 0 ? 0.0 : nodes[b].value));
+        }
+
+        //Algebraic simplifications
+        bool b_is_const = b >= 0 && nodes[b].op == CONSTANT;
+        switch( op ) {
+            case NEG:
+                if( nodes[a].op == NEG ) return nodes[a].a;
+            break;
+            case ADD:
+                if( a_const && nodes[a].value == 0.0 ) return b;
+                if( b_is_const && nodes[b].value == 0.0 ) return a;
+            break;
+            case SUB:
+                if( b_is_const && nodes[b].value == 0.0 ) return a;
+                if( a_const && nodes[a].value == 0.0 ) return addNode(NEG,b);
+            break;
+            case MUL:
+                if( a_const && nodes[a].value == 0.0 ) return a;
+                if( b_is_const && nodes[b].value == 0.0 ) return b;
+                if( a_const && nodes[a].value == 1.0 ) return b;
+                if( b_is_const && nodes[b].value == 1.0 ) return a;
+                if( a_const && nodes[a].value == -1.0 ) return addNode(NEG,b);
+                if( b_is_const && nodes[b].value == -1.0 ) return addNode(NEG,a);
+            break;
+            case DIV:
+                if( b_is_const && nodes[b].value == 1.0 ) return a;
+            break;
+        }
+
+        //Canonical order of the operands of commutative operations, to share more subexpressions
+        if( (op == ADD || op == MUL) && a > b ) std::swap(a,b);
+    }
+
+    node n;
+    n.op = op;
+    n.a = a;
+    n.b = b;
+    n.value = value;
+
+    std::map<node,int>::const_iterator it = unique_nodes.find(n);
+    if( it != unique_nodes.end() ) return it->second;
+
+    nodes.push_back(n);
+    unique_nodes.insert(std::make_pair(n,(int)nodes.size()-1));
+    return nodes.size()-1;
+}
+
+int symoro_code_evaluator::getVariableNode(const std::string & name)
+{
+    std::map<std::string,int>::const_iterator it = variables.find(name);
+    if( it != variables.end() ) return it->second;
+
+    if( name == "M_PI" ) return addConstant(M_PI);
+
+    //Variables read before being assigned are inputs
+    int input = addNode(INPUT,input_names.size());
+    input_names.push_back(name);
+    input_nodes.push_back(input);
+    variables[name] = input;
+    return input;
+}
+
+bool symoro_code_evaluator::parseExpression(const char * & p, int & result)
+{
+    if( !parseTerm(p,result) ) return false;
+    while( true ) {
+        p = skip_blanks(p);
+        if( *p != '+' && *p != '-' ) return true;
+        int op = (*p == '+') ? ADD : SUB;
+        p++;
+        int rhs;
+        if( !parseTerm(p,rhs) ) return false;
+        result = addNode(op,result,rhs);
+    }
+}
+
+bool symoro_code_evaluator::parseTerm(const char * & p, int & result)
+{
+    if( !parseFactor(p,result) ) return false;
+    while( true ) {
+        p = skip_blanks(p);
+        if( *p != '*' && *p != '/' ) return true;
+        int op = (*p == '*') ? MUL : DIV;
+        p++;
+        int rhs;
+        if( !parseFactor(p,rhs) ) return false;
+        result = addNode(op,result,rhs);
+    }
+}
+
+bool symoro_code_evaluator::parseFactor(const char * & p, int & result)
+{
+    p = skip_blanks(p);
+    if( *p == '-' ) {
+        p++;
+        if( !parseFactor(p,result) ) return false;
+        result = addNode(NEG,result);
+        return true;
+    }
+    if( *p == '+' ) {
+        p++;
+        return parseFactor(p,result);
+    }
+    return parsePrimary(p,result);
+}
+
+struct symoro_code_function
+{
+    const char * name;
+    int op;
+    int nr_of_arguments;
+};
+
+bool symoro_code_evaluator::parsePrimary(const char * & p, int & result)
+{
+    static const symoro_code_function functions[] = {
+        {"sin",SIN,1}, {"cos",COS,1}, {"tan",TAN,1}, {"asin",ASIN,1}, {"acos",ACOS,1},
+        {"atan",ATAN,1}, {"atan2",ATAN2,2}, {"sqrt",SQRT,1}, {"exp",EXP,1}, {"log",LOG,1},
+        {"abs",ABS,1}, {"fabs",ABS,1}, {"sign",SIGN,1}, {"pow",POW,2} };
+    static const int nr_of_functions = sizeof(functions)/sizeof(functions[0]);
+
+    p = skip_blanks(p);
+
+    if( *p == '(' ) {
+        p++;
+        if( !parseExpression(p,result) ) return false;
+        p = skip_blanks(p);
+        if( *p != ')' ) return false;
+        p++;
+        return true;
+    }
+
+    if( is_digit(*p) || (*p == '.' && is_digit(p[1])) ) {
+        double value;
+        p = scanDouble(p,0,value);
+        result = addConstant(value);
+        return true;
+    }
+
+    std::string name;
+    if( !parse_name(p,name) ) return false;
+    const char * after_name = skip_blanks(p);
+
+    if( *after_name == '(' ) {
+        for(int f=0; f < nr_of_functions; f++ ) {
+            if( name != functions[f].name ) continue;
+            p = after_name+1;
+            int args[2] = {-1,-1};
+            for(int a=0; a < functions[f].nr_of_arguments; a++ ) {
+                if( a > 0 ) {
+                    p = skip_blanks(p);
+                    if( *p != ',' ) return false;
+                    p++;
+                }
+                if( !parseExpression(p,args[a]) ) return false;
+            }
+            p = skip_blanks(p);
+            if( *p != ')' ) return false;
+            p++;
+            result = addNode(functions[f].op,args[0],args[1]);
+            return true;
+        }
+
+        //Access to an element of an input vector or matrix, as q(0)
+        int row, col;
+        const char * q = after_name;
+        if( !parse_indices(q,row,col) ) return false;
+        std::string element(after_name,q);
+        element.erase(std::remove_if(element.begin(),element.end(),is_blank),element.end());
+        p = q;
+        result = getVariableNode(name+element);
+        return true;
+    }
+
+    result = getVariableNode(name);
+    return true;
+}
+
+bool symoro_code_evaluator::parseStatement(const std::string & statement)
+{
+    const char * p = skip_blanks(statement.c_str());
+    if( strncmp(p,"const ",6) == 0 ) p = skip_blanks(p+6);
+    if( strncmp(p,"double ",7) == 0 ) p = skip_blanks(p+7);
+
+    //Only assignments NAME = ..., NAME(i) = ... and NAME(i,j) = ... are considered
+    std::string name;
+    if( !parse_name(p,name) ) return true;
+    p = skip_blanks(p);
+    int row = -1, col = -1;
+    bool is_output = parse_indices(p,row,col);
+    p = skip_blanks(p);
+    if( *p != '=' || p[1] == '=' ) return true;
+    p++;
+
+    int result;
+    if( !parseExpression(p,result) || *skip_blanks(p) != '\0' ) {
+        std::cerr << "Error: could not parse the expression in the statement " << statement << std::endl;
+        return false;
+    }
+
+    if( is_output ) {
+        outputs[name][std::make_pair(row,col)] = result;
+    } else {
+        variables[name] = result;
+    }
+    return true;
+}
+
+void symoro_code_evaluator::compile()
+{
+    std::vector<bool> needed(nodes.size(),false);
+    std::map<std::string, std::map<std::pair<int,int>,int> >::const_iterator out;
+    for(out = outputs.begin(); out != outputs.end(); out++ ) {
+        std::map<std::pair<int,int>,int>::const_iterator el;
+        for(el = out->second.begin(); el != out->second.end(); el++ ) {
+            needed[el->second] = true;
+        }
+    }
+
+    //Operands always precede the nodes using them
+    for(int n=nodes.size()-1; n >= 0; n-- ) {
+        if( !needed[n] || nodes[n].op == CONSTANT || nodes[n].op == INPUT ) continue;
+        needed[nodes[n].a] = true;
+        if( nodes[n].b >= 0 ) needed[nodes[n].b] = true;
+    }
+
+    program.clear();
+    values.assign(nodes.size(),0.0);
+    for(int n=0; n < (int)nodes.size(); n++ ) {
+        if( nodes[n].op == CONSTANT ) {
+            values[n] = nodes[n].value;
+        } else if( needed[n] && nodes[n].op != INPUT ) {
+            program.push_back(n);
+        }
+    }
+}
+
+bool symoro_code_evaluator::loadFromString(const std::string & code)
+{
+    clear();
+
+    //Split the code in statements, discarding comments and preprocessor directives
+    std::string statement;
+    bool line_start = true;
+    for(size_t i=0; i < code.size(); i++ ) {
+        char c = code[i];
+        if( c == '/' && i+1 < code.size() && code[i+1] == '/' ) {
+            while( i+1 < code.size() && code[i+1] != '\n' ) i++;
+        } else if( c == '/' && i+1 < code.size() && code[i+1] == '*' ) {
+            size_t end = code.find("*/",i+2);
+            i = (end == std::string::npos) ? code.size() : end+1;
+            statement += ' ';
+        } else if( c == '#' && line_start ) {
+            while( i+1 < code.size() && code[i+1] != '\n' ) i++;
+        } else if( c == ';' || c == '{' || c == '}' ) {
+            if( !parseStatement(statement) ) { clear(); return false; }
+            statement.clear();
+        } else {
+            statement += c;
+        }
+        if( c == '\n' ) line_start = true;
+        else if( !is_blank(c) ) line_start = false;
+    }
+    if( !parseStatement(statement) ) { clear(); return false; }
+
+    compile();
+    return true;
+}
+
+bool symoro_code_evaluator::loadFromFile(const std::string & file_name)
+{
+    std::ifstream ifs(file_name.c_str());
+    if( !ifs.is_open() ) {
+        std::cerr << "Error: could not open file " << file_name << std::endl;
+        return false;
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return loadFromString(ss.str());
+}
+
+int symoro_code_evaluator::getInputIndex(const std::string & name) const
+{
+    for(int i=0; i < (int)input_names.size(); i++ ) {
+        if( input_names[i] == name ) return i;
+    }
+    return -1;
+}
+
+bool symoro_code_evaluator::setInput(const std::string & name, const double value)
+{
+    int index = getInputIndex(name);
+    if( index < 0 ) return false;
+    setInput(index,value);
+    return true;
+}
+
+void symoro_code_evaluator::evaluate()
+{
+    for(size_t i=0; i < program.size(); i++ ) {
+        const node & n = nodes[program[i]];
+        values[program[i]] = apply(n.op,values[n.a],n.b < 0 ? 0.0 : values[n.b]);
+    }
+}
+
+bool symoro_code_evaluator::getOutput(const std::string & name, Eigen::MatrixXd & output) const
+{
+    std::map<std::string, std::map<std::pair<int,int>,int> >::const_iterator out = outputs.find(name);
+    if( out == outputs.end() ) return false;
+
+    int rows = output.rows(), cols = output.cols();
+    std::map<std::pair<int,int>,int>::const_iterator el;
+    for(el = out->second.begin(); el != out->second.end(); el++ ) {
+        rows = std::max(rows,el->first.first+1);
+        cols = std::max(cols,el->first.second+1);
+    }
+    if( rows != output.rows() || cols != output.cols() ) output.resize(rows,cols);
+
+    output.setZero();
+    for(el = out->second.begin(); el != out->second.end(); el++ ) {
+        output(el->first.first,el->first.second) = values[el->second];
+    }
+    return true;
+}
+
+}
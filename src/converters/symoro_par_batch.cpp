@@ -0,0 +1,184 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/symoro_par_batch.hpp"
+#include "kdl_format_io/symoro_par_import.hpp"
+
+#include "symoro_par_utils.hpp"
+#include <iostream>
+#include <algorithm>
+
+using namespace KDL;
+using namespace std;
+
+namespace kdl_format_io {
+
+symoro_par_batch::symoro_par_batch(const symoro_par_model & par_model, const bool _consider_root_link_inertia):
+    model(par_model), consider_root_link_inertia(_consider_root_link_inertia), valid(false)
+{
+    if( (model.Type != 0 && model.Type != 1) || !model.isConsistent() ) {
+        std::cerr << "Error: batch instantiation supports only consistent SYMORO+ models of Type Tree (1) and Simple Chain (0)" << std::endl;
+        return;
+    }
+
+    //The structure is checked building the tree of the nominal model once,
+    //the tree is then used as template of the instances
+    symoro_par_names names;
+    parModelNames(model,consider_root_link_inertia,names);
+    if( !treeFromParModelNames(model,names,nominal_tree) ) return;
+
+    parameter_names = model.geometric_parameter_names;
+    entries = model.geometric_entries;
+
+    valid = true;
+}
+
+int symoro_par_batch::addParameter(const std::string & name, const int link, const int field)
+{
+    if( !valid || link < 0 || link >= model.NL || field < 0 || field > THETA_FIELD ) {
+        std::cerr << "Error: invalid link or field for parameter " << name << std::endl;
+        return -1;
+    }
+
+    for(size_t e=0; e < entries.size(); e++ ) {
+        if( entries[e].link == link && entries[e].field == field ) {
+            std::cerr << "Error: the entry of parameter " << name << " already depends on parameter "
+                      << parameter_names[entries[e].parameter] << std::endl;
+            return -1;
+        }
+    }
+
+    symoro_par_symbolic_entry entry;
+    entry.link = link;
+    entry.field = field;
+    entry.parameter = parameter_names.size();
+    entries.push_back(entry);
+    parameter_names.push_back(name);
+
+    return entry.parameter;
+}
+
+void symoro_par_batch::getNominalParameters(std::vector<double> & values) const
+{
+    values.assign(parameter_names.size(),0.0);
+    for(size_t e=model.geometric_entries.size(); e < entries.size(); e++ ) {
+        const symoro_par_link_field<double> & field = entries[e].field == THETA_FIELD ? model.Theta : model.geometricField(entries[e].field);
+        values[entries[e].parameter] = field[entries[e].link];
+    }
+}
+
+bool symoro_par_batch::checkValues(const double * values, const int nr_of_instances) const
+{
+    if( !valid ) return false;
+
+    if( nr_of_instances < 0 || (nr_of_instances > 0 && parameter_names.size() > 0 && values == 0) ) {
+        std::cerr << "Error: invalid parameter values for batch instantiation" << std::endl;
+        return false;
+    }
+
+    //As in bindGeometricParameters, the chain must remain a chain
+    if( model.Type != 0 ) return true;
+    for(int i=0; i < nr_of_instances; i++ ) {
+        for(size_t e=0; e < entries.size(); e++ ) {
+            if( (entries[e].field == symoro_par_model::B_FIELD || entries[e].field == symoro_par_model::GAMMA_FIELD)
+                && values[i*parameter_names.size()+entries[e].parameter] != 0.0 ) {
+                std::cerr << "Error: B and gamma should be 0 in a SYMORO+ simple chain" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void symoro_par_batch::bindValues(const double * values, symoro_par_model & instance) const
+{
+    for(size_t e=0; e < entries.size(); e++ ) {
+        symoro_par_link_field<double> & field = entries[e].field == THETA_FIELD ? instance.Theta : instance.geometricField(entries[e].field);
+        field[entries[e].link] = values[entries[e].parameter];
+    }
+}
+
+bool symoro_par_batch::instantiateModels(const double * values, const int nr_of_instances, std::vector<symoro_par_model> & models) const
+{
+    if( !checkValues(values,nr_of_instances) ) return false;
+
+    const int nr_of_parameters = parameter_names.size();
+    models.resize(nr_of_instances);
+
+    #pragma omp parallel for
+    for(int i=0; i < nr_of_instances; i++ ) {
+        models[i] = model;
+        bindValues(values+i*nr_of_parameters,models[i]);
+    }
+
+    return true;
+}
+
+bool symoro_par_batch::instantiateTrees(const double * values, const int nr_of_instances, std::vector<KDL::Tree> & trees) const
+{
+    if( !checkValues(values,nr_of_instances) ) return false;
+
+    const int nr_of_parameters = parameter_names.size();
+    trees.resize(nr_of_instances);
+
+    symoro_par_names names;
+    parModelNames(model,consider_root_link_inertia,names);
+
+    //Only the segments of the links with an entry depend on the parameters,
+    //the others are copied from the tree of the nominal model
+    std::vector<bool> rebuilt_links(model.NL,false);
+    for(size_t e=0; e < entries.size(); e++ ) {
+        rebuilt_links[entries[e].link] = true;
+    }
+
+    //The values are checked and the structure of the model is valid, so treeFromParModelTemplate
+    //can not fail. Each thread binds the values in its own copy of the model, and all the
+    //trees share the names of links and joints.
+    #pragma omp parallel
+    {
+        symoro_par_model instance = model;
+
+        #pragma omp for
+        for(int i=0; i < nr_of_instances; i++ ) {
+            bindValues(values+i*nr_of_parameters,instance);
+            treeFromParModelTemplate(instance,names,nominal_tree,rebuilt_links,std::vector<bool>(),trees[i]);
+        }
+    }
+
+    return true;
+}
+
+}
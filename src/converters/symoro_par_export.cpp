@@ -0,0 +1,528 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/symoro_par_export.hpp"
+
+#include "symoro_par_utils.hpp"
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <kdl/tree.hpp>
+
+using namespace KDL;
+using namespace std;
+
+namespace kdl_format_io {
+
+/**
+ * Threshold under which a vector is considered null (parallel axes)
+ * and a parameter is exported as zero
+ */
+static const double par_export_tolerance = 1e-10;
+
+/**
+ * Line in space, used for representing joint axes
+ */
+struct par_export_line
+{
+    Vector p;   ///< a point of the line
+    Vector z;   ///< the (unit) direction of the line
+};
+
+/**
+ * Link of the exported par model
+ */
+struct par_export_link
+{
+    SegmentMap::const_iterator element;
+    int parent;             ///< index of the parent link, -1 if the parent is the root of the tree
+    par_export_line axis;   ///< joint axis (z axis of dh_frame), expressed in the segment frame
+    Frame dh_frame;         ///< frame of the link in the SyMoRo convention, expressed in the segment frame
+};
+
+static double snapToZero(const double value)
+{
+    return fabs(value) < par_export_tolerance ? 0.0 : value;
+}
+
+static void addTreeLinks(const SegmentMap::const_iterator & element, const int parent, std::vector<par_export_link> & links)
+{
+    for(size_t c=0; c < element->second.children.size(); c++ ) {
+        par_export_link link;
+        link.element = element->second.children[c];
+        link.parent = parent;
+        links.push_back(link);
+        addTreeLinks(link.element,links.size()-1,links);
+    }
+}
+
+/**
+ * Compute the axis of the joint of a segment, expressed in the segment frame.
+ * For a fixed joint, the z axis of the segment frame is used.
+ */
+static bool segmentAxis(const Segment & segment, par_export_line & axis)
+{
+    const Joint & joint = segment.getJoint();
+    if( joint.getType() == Joint::None ) {
+        axis.p = Vector::Zero();
+        axis.z = Vector(0,0,1);
+        return true;
+    }
+
+    Frame link_parent = segment.pose(0.0).Inverse();
+    axis.p = link_parent*joint.JointOrigin();
+    axis.z = link_parent.M*joint.JointAxis();
+    if( axis.z.Norm() < par_export_tolerance ) {
+        std::cerr << "Error: joint " << joint.getName() << " has a null axis" << std::endl;
+        return false;
+    }
+    axis.z = axis.z/axis.z.Norm();
+    return true;
+}
+
+/**
+ * Compute the common normal between the line a and the line b: x is its (unit)
+ * direction, and foot the point of line a from where it starts. For parallel lines
+ * the normal passing through b.p is used, for coincident lines x is the
+ * projection of x_hint (or of an axis orthogonal to a.z) on the plane orthogonal to a.z
+ */
+static void commonNormal(const par_export_line & a, const par_export_line & b, const Vector & x_hint,
+                         Vector & x, Vector & foot)
+{
+    Vector n = a.z*b.z;
+    Vector w = b.p-a.p;
+    if( n.Norm() > par_export_tolerance ) {
+        double c = dot(a.z,b.z);
+        x = n/n.Norm();
+        foot = a.p + a.z*((dot(w,a.z)-c*dot(w,b.z))/(1-c*c));
+        return;
+    }
+
+    foot = a.p + a.z*dot(w,a.z);
+    x = b.p-foot;
+    if( x.Norm() > par_export_tolerance ) {
+        x = x/x.Norm();
+        return;
+    }
+
+    x = x_hint - a.z*dot(x_hint,a.z);
+    if( x.Norm() < 0.5 ) {
+        Vector other_hint = fabs(a.z.x()) < 0.5 ? Vector(1,0,0) : Vector(0,1,0);
+        x = other_hint - a.z*dot(other_hint,a.z);
+    }
+    x = x/x.Norm();
+}
+
+/**
+ * Decompose the transform between the frames of two links as
+ * T = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
+ * The common normal between the two z axes is used as intermediate x axis, for
+ * parallel z axes b is set to 0.
+ */
+static void khalilParameters(const Frame & T, double & gamma, double & b, double & alpha,
+                             double & d, double & theta, double & r)
+{
+    par_export_line parent_axis, child_axis;
+    parent_axis.p = Vector::Zero();
+    parent_axis.z = Vector(0,0,1);
+    child_axis.p = T.p;
+    child_axis.z = T.M.UnitZ();
+
+    Vector x, foot;
+    commonNormal(parent_axis,child_axis,Vector(1,0,0),x,foot);
+
+    Vector p = T.p;
+    Vector z = child_axis.z;
+    double c = dot(parent_axis.z,z);
+    d = dot(p,x);
+    if( (parent_axis.z*z).Norm() > par_export_tolerance ) {
+        b = (p.z()-c*dot(p,z))/(1-c*c);
+        r = (dot(p,z)-c*p.z())/(1-c*c);
+    } else {
+        b = 0.0;
+        r = dot(p,z);
+    }
+
+    gamma = atan2(x.y(),x.x());
+    alpha = atan2(dot(parent_axis.z*z,x),c);
+    theta = atan2(dot(x*T.M.UnitX(),z),dot(x,T.M.UnitX()));
+}
+
+bool treeToParModel(const Tree& tree, symoro_par_model& par_model)
+{
+    std::vector<par_export_link> links;
+    addTreeLinks(tree.getRootSegment(),-1,links);
+
+    const int NL = links.size();
+    par_model = symoro_par_model();
+    par_model.NF = par_model.NL = par_model.NJ = NL;
+    par_model.reserveLinks(NL);
+    par_model.Ant.resize(NL);
+    par_model.Sigma.resize(NL);
+    par_model.Mu.resize(NL);
+    par_model.B.resize(NL);
+    par_model.d.resize(NL);
+    par_model.R.resize(NL);
+    par_model.gamma.resize(NL);
+    par_model.Alpha.resize(NL);
+    par_model.Theta.resize(NL);
+    for(int f=0; f < symoro_par_model::NR_OF_INERTIAL_FIELDS; f++ ) {
+        par_model.inertialField(f).resize(NL);
+    }
+
+    for(int l=0; l < NL; l++ ) {
+        const Segment & segment = links[l].element->second.segment;
+        switch( segment.getJoint().getType() ) {
+            case Joint::None:
+                par_model.Sigma[l] = 2;
+            break;
+            case Joint::RotAxis:
+            case Joint::RotX:
+            case Joint::RotY:
+            case Joint::RotZ:
+                par_model.Sigma[l] = 0;
+            break;
+            case Joint::TransAxis:
+            case Joint::TransX:
+            case Joint::TransY:
+            case Joint::TransZ:
+                par_model.Sigma[l] = 1;
+            break;
+            default:
+                std::cerr << "Error: joint " << segment.getJoint().getName() << " has a type not supported by the SYMORO+ par format" << std::endl;
+                return false;
+            break;
+        }
+        par_model.Mu[l] = par_model.Sigma[l] == 2 ? 0 : 1;
+        par_model.Ant[l] = links[l].parent+1;
+        if( !segmentAxis(segment,links[l].axis) ) return false;
+    }
+
+    //The frame of a link has the z axis along the joint axis and the x axis along
+    //the common normal with the joint axis of its first child: in this way chains
+    //have gamma = 0 and b = 0. The frame of fixed links is the segment frame.
+    for(int l=0; l < NL; l++ ) {
+        const TreeElement & element = links[l].element->second;
+        const par_export_line & axis = links[l].axis;
+        if( par_model.Sigma[l] == 2 ) {
+            links[l].dh_frame = Frame::Identity();
+            continue;
+        }
+
+        Vector x, foot;
+        if( element.children.size() > 0 ) {
+            const Segment & child = element.children[0]->second.segment;
+            par_export_line child_axis;
+            if( !segmentAxis(child,child_axis) ) return false;
+            Frame link_child = child.pose(0.0);
+            child_axis.p = link_child*child_axis.p;
+            child_axis.z = link_child.M*child_axis.z;
+            commonNormal(axis,child_axis,Vector(1,0,0),x,foot);
+        } else {
+            par_export_line origin;
+            origin.p = Vector::Zero();
+            origin.z = axis.z;
+            commonNormal(axis,origin,Vector(1,0,0),x,foot);
+        }
+        links[l].dh_frame = Frame(Rotation(x,axis.z*x,axis.z),foot);
+    }
+
+    bool is_chain = true;
+    for(int l=0; l < NL; l++ ) {
+        const Segment & segment = links[l].element->second.segment;
+        const int parent = links[l].parent;
+        Frame parent_dh_link = parent < 0 ? Frame::Identity() : links[parent].dh_frame.Inverse();
+
+        double gamma, b, alpha, d, theta, r;
+        khalilParameters(parent_dh_link*segment.pose(0.0)*links[l].dh_frame,gamma,b,alpha,d,theta,r);
+        par_model.gamma[l] = snapToZero(gamma);
+        par_model.B[l] = snapToZero(b);
+        par_model.Alpha[l] = snapToZero(alpha);
+        par_model.d[l] = snapToZero(d);
+        par_model.Theta[l] = snapToZero(theta);
+        par_model.R[l] = snapToZero(r);
+
+        //Round-trip check of the parameters, also for a non-zero joint position
+        const double q_test = 0.5;
+        double q_theta = par_model.Sigma[l] == 0 ? q_test : 0.0;
+        double q_r = par_model.Sigma[l] == 1 ? q_test : 0.0;
+        Frame expected = parent_dh_link*segment.pose(par_model.Sigma[l] == 2 ? 0.0 : q_test)*links[l].dh_frame;
+        Frame parent_child = DH_Khalil1986_Tree(par_model.d[l],par_model.Alpha[l],par_model.R[l]+q_r,
+                                                par_model.Theta[l]+q_theta,par_model.gamma[l],par_model.B[l]);
+        if( !Equal(expected,parent_child,1e-8) ) {
+            std::cerr << "Error: segment " << segment.getName() << " can not be represented with the SYMORO+ geometric parameters (is the joint scale different from 1?)" << std::endl;
+            return false;
+        }
+
+        if( par_model.Ant[l] != l || par_model.B[l] != 0.0 || par_model.gamma[l] != 0.0 ) is_chain = false;
+
+        //SyMoRo inertial parameters are expressed with respect to the link frame origin
+        RigidBodyInertia inertia = links[l].dh_frame.Inverse()*segment.getInertia();
+        double mass = inertia.getMass();
+        Vector first_moment = inertia.getCOG()*mass;
+        RotationalInertia rot_inertia = inertia.getRotationalInertia();
+        par_model.XX[l] = snapToZero(rot_inertia.data[0]);
+        par_model.XY[l] = snapToZero(rot_inertia.data[1]);
+        par_model.XZ[l] = snapToZero(rot_inertia.data[2]);
+        par_model.YY[l] = snapToZero(rot_inertia.data[4]);
+        par_model.YZ[l] = snapToZero(rot_inertia.data[5]);
+        par_model.ZZ[l] = snapToZero(rot_inertia.data[8]);
+        par_model.MX[l] = snapToZero(first_moment.x());
+        par_model.MY[l] = snapToZero(first_moment.y());
+        par_model.MZ[l] = snapToZero(first_moment.z());
+        par_model.M[l] = mass;
+    }
+
+    par_model.Type = is_chain ? 0 : 1;
+
+    return true;
+}
+
+/**
+ * Format a number, writing multiples of Pi/2 in symbolic form
+ */
+static std::string parNumber(const double value, const bool is_angle)
+{
+    if( is_angle ) {
+        double half_turns = value/(M_PI/2);
+        double rounded = floor(half_turns+0.5);
+        if( rounded != 0.0 && fabs(half_turns-rounded) < 1e-12 ) {
+            int k = (int)rounded;
+            std::stringstream ss;
+            if( k % 2 == 0 ) {
+                if( k == 2 ) { ss << "Pi"; } else if( k == -2 ) { ss << "-Pi"; } else { ss << k/2 << "*Pi"; }
+            } else {
+                if( k == 1 ) { ss << "Pi/2"; } else if( k == -1 ) { ss << "-Pi/2"; } else { ss << k << "*Pi/2"; }
+            }
+            return ss.str();
+        }
+    }
+    char buf[32];
+    snprintf(buf,sizeof(buf),"%.15g",snapToZero(value));
+    return buf;
+}
+
+static void writeParVector(std::ostream & out, const std::string & name, const std::vector<std::string> & entries)
+{
+    out << name << " = {" << std::endl << "        ";
+    for(size_t i=0; i < entries.size(); i++ ) {
+        if( i != 0 ) {
+            out << ",";
+            if( i % 10 == 0 ) out << std::endl << "        ";
+        }
+        out << entries[i];
+    }
+    out << "}" << std::endl;
+}
+
+static void writeParConstantVector(std::ostream & out, const std::string & name, const std::string & value, const int size)
+{
+    writeParVector(out,name,std::vector<std::string>(size,value));
+}
+
+static void writeParSymbolVector(std::ostream & out, const std::string & name, const int size)
+{
+    std::vector<std::string> entries(size);
+    for(int l=0; l < size; l++ ) { entries[l] = name + int2string(l+1); }
+    writeParVector(out,name,entries);
+}
+
+static void writeParIntVector(std::ostream & out, const std::string & name, const symoro_par_link_field<int> & values)
+{
+    std::vector<std::string> entries(values.size());
+    for(int l=0; l < values.size(); l++ ) { entries[l] = int2string(values[l]); }
+    writeParVector(out,name,entries);
+}
+
+/**
+ * Write a par model, adding a comment with the names of the links if link_names
+ * is not NULL (link_names[0] is the base, link_names[l+1] is the name of link l)
+ */
+static bool writeParModel(const symoro_par_model& par_model, const std::vector<std::string> * link_names, std::string& parfile_content)
+{
+    if( (par_model.Type != 0 && par_model.Type != 1) || !par_model.isConsistent() ) {
+        std::cerr << "Error: only consistent SYMORO+ models of Type Tree (1) and Simple Chain (0) can be written" << std::endl;
+        return false;
+    }
+
+    const int NL = par_model.NL;
+    std::stringstream out;
+
+    out << "(*******************************************)" << std::endl;
+    out << "(*     SYMORO+ : Parameters of a robot     *)" << std::endl;
+    out << "(*   generated by kdl_format_io            *)" << std::endl;
+    out << "(*******************************************)" << std::endl << std::endl;
+
+    out << "(* General parameters *)" << std::endl;
+    out << "(* Robotname = '" << par_model.name << "' *)" << std::endl;
+    out << "NF = " << par_model.NF << std::endl;
+    out << "NL = " << par_model.NL << std::endl;
+    out << "NJ = " << par_model.NJ << std::endl;
+    out << "Type = " << par_model.Type << (par_model.Type == 0 ? " (* Simple *)" : " (* Tree *)") << std::endl << std::endl;
+
+    if( link_names ) {
+        out << "(* Links" << std::endl;
+        for(size_t l=0; l < link_names->size(); l++ ) {
+            out << "    " << l << " : " << (*link_names)[l] << std::endl;
+        }
+        out << "*)" << std::endl << std::endl;
+    }
+
+    out << "(* Geometric parameters *)" << std::endl;
+    writeParIntVector(out,"Ant",par_model.Ant);
+    writeParIntVector(out,"Sigma",par_model.Sigma);
+
+    std::vector<std::string> entries(NL);
+    const symoro_par_model::geometric_field geometric_fields[] = { symoro_par_model::B_FIELD, symoro_par_model::D_FIELD,
+                                                                   symoro_par_model::R_FIELD, symoro_par_model::GAMMA_FIELD,
+                                                                   symoro_par_model::ALPHA_FIELD };
+    for(int f=0; f < symoro_par_model::NR_OF_GEOMETRIC_FIELDS; f++ ) {
+        const int field = geometric_fields[f];
+        const bool is_angle = field == symoro_par_model::GAMMA_FIELD || field == symoro_par_model::ALPHA_FIELD;
+        for(int l=0; l < NL; l++ ) { entries[l] = parNumber(par_model.geometricField(field)[l],is_angle); }
+        for(size_t e=0; e < par_model.geometric_entries.size(); e++ ) {
+            const symoro_par_symbolic_entry & entry = par_model.geometric_entries[e];
+            if( entry.field == field ) entries[entry.link] = par_model.geometric_parameter_names[entry.parameter];
+        }
+        writeParVector(out,symoro_par_model::geometricFieldName(field),entries);
+        if( field == symoro_par_model::ALPHA_FIELD ) writeParIntVector(out,"Mu",par_model.Mu);
+    }
+
+    //The joint variables of rotational joints are part of the Theta expressions
+    for(int l=0; l < NL; l++ ) {
+        std::string offset = parNumber(par_model.Theta[l],true);
+        if( par_model.Sigma[l] != 0 ) {
+            entries[l] = offset;
+        } else if( par_model.Theta[l] == 0.0 ) {
+            entries[l] = "t" + int2string(l+1);
+        } else {
+            entries[l] = "t" + int2string(l+1) + (offset[0] == '-' ? "" : "+") + offset;
+        }
+    }
+    writeParVector(out,"Theta",entries);
+    out << std::endl;
+
+    out << "(* Dynamic parameters and external forces *)" << std::endl;
+    for(int f=0; f < symoro_par_model::NR_OF_INERTIAL_FIELDS; f++ ) {
+        if( !par_model.hasInertialParameters() ) {
+            writeParSymbolVector(out,symoro_par_model::inertialFieldName(f),NL);
+            continue;
+        }
+        for(int l=0; l < NL; l++ ) { entries[l] = parNumber(par_model.inertialField(f)[l],false); }
+        for(size_t e=0; e < par_model.inertial_entries.size(); e++ ) {
+            const symoro_par_symbolic_entry & entry = par_model.inertial_entries[e];
+            if( entry.field == f ) entries[entry.link] = par_model.inertial_parameter_names[entry.parameter];
+        }
+        writeParVector(out,symoro_par_model::inertialFieldName(f),entries);
+    }
+    const char * external_fields[] = {"IA","FV","FS","FX","FY","FZ","CX","CY","CZ"};
+    for(int f=0; f < 9; f++ ) { writeParConstantVector(out,external_fields[f],"0",NL); }
+    out << std::endl;
+
+    out << "(* Joints velocity and acceleration *)" << std::endl;
+    writeParSymbolVector(out,"QP",NL);
+    writeParSymbolVector(out,"QDP",NL);
+    out << std::endl;
+
+    out << "(* Speed and acceleration of the base *)" << std::endl;
+    writeParConstantVector(out,"W0","0",3);
+    writeParConstantVector(out,"WP0","0",3);
+    writeParConstantVector(out,"V0","0",3);
+    writeParConstantVector(out,"VP0","0",3);
+    out << std::endl;
+
+    out << "(* Matrix Z *)" << std::endl;
+    out << "Z = {" << std::endl << "        1,0,0,0,0,1,0,0,0,0," << std::endl << "        1,0,0,0,0,1}" << std::endl << std::endl;
+
+    out << "(* Acceleration of gravity *)" << std::endl;
+    out << "G = {" << std::endl << "        0,0,G3}" << std::endl << std::endl;
+
+    out << "(* End of definition *)" << std::endl;
+
+    parfile_content = out.str();
+    return true;
+}
+
+bool parModelToString(const symoro_par_model& par_model, std::string& parfile_content)
+{
+    return writeParModel(par_model,0,parfile_content);
+}
+
+static bool writeParFile(const std::string& parfile_name, const std::string& parfile_content)
+{
+    std::ofstream ofs(parfile_name.c_str());
+    if( !ofs.is_open() ) {
+        std::cerr << "Error: could not open file " << parfile_name << std::endl;
+        return false;
+    }
+    ofs << parfile_content;
+    return ofs.good();
+}
+
+bool parModelToFile(const std::string& parfile_name, const symoro_par_model& par_model)
+{
+    std::string parfile_content;
+    if( !parModelToString(par_model,parfile_content) ) return false;
+    return writeParFile(parfile_name,parfile_content);
+}
+
+bool treeToSymoroParString(const Tree& tree, std::string& parfile_content, const std::string & robot_name)
+{
+    symoro_par_model par_model;
+    if( !treeToParModel(tree,par_model) ) return false;
+    par_model.name = robot_name;
+
+    std::vector<par_export_link> links;
+    addTreeLinks(tree.getRootSegment(),-1,links);
+    std::vector<std::string> link_names(links.size()+1);
+    link_names[0] = tree.getRootSegment()->second.segment.getName();
+    for(size_t l=0; l < links.size(); l++ ) { link_names[l+1] = links[l].element->second.segment.getName(); }
+
+    return writeParModel(par_model,&link_names,parfile_content);
+}
+
+bool treeToSymoroParFile(const std::string& parfile_name, const Tree& tree, const std::string & robot_name)
+{
+    std::string parfile_content;
+    if( !treeToSymoroParString(tree,parfile_content,robot_name) ) return false;
+    return writeParFile(parfile_name,parfile_content);
+}
+
+}
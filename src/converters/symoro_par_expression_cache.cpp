@@ -0,0 +1,180 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/symoro_par_expression_cache.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace kdl_format_io {
+
+//The cache can be shared by threads created in any way (not only by OpenMP),
+//so it is always protected by a mutex of the platform
+#ifdef _WIN32
+typedef CRITICAL_SECTION symoro_par_expression_cache_mutex;
+#else
+typedef pthread_mutex_t symoro_par_expression_cache_mutex;
+#endif
+
+symoro_par_expression_cache::symoro_par_expression_cache(const int _max_nr_of_expressions):
+    max_nr_of_expressions(_max_nr_of_expressions), nr_of_lookups(0), nr_of_hits(0), lock(0)
+{
+    symoro_par_expression_cache_mutex * mutex = new symoro_par_expression_cache_mutex;
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex,0);
+#endif
+    lock = mutex;
+}
+
+symoro_par_expression_cache::~symoro_par_expression_cache()
+{
+    symoro_par_expression_cache_mutex * mutex = static_cast<symoro_par_expression_cache_mutex *>(lock);
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+    delete mutex;
+}
+
+void symoro_par_expression_cache::acquire() const
+{
+#ifdef _WIN32
+    EnterCriticalSection(static_cast<symoro_par_expression_cache_mutex *>(lock));
+#else
+    pthread_mutex_lock(static_cast<symoro_par_expression_cache_mutex *>(lock));
+#endif
+}
+
+void symoro_par_expression_cache::release() const
+{
+#ifdef _WIN32
+    LeaveCriticalSection(static_cast<symoro_par_expression_cache_mutex *>(lock));
+#else
+    pthread_mutex_unlock(static_cast<symoro_par_expression_cache_mutex *>(lock));
+#endif
+}
+
+bool symoro_par_expression_cache::lookup(const char * begin, const char * end, double & value)
+{
+    std::string expression(begin,end);
+
+    acquire();
+    nr_of_lookups++;
+    std::map<std::string,cache_entry>::iterator it = entries.find(expression);
+    bool found = (it != entries.end());
+    if( found ) {
+        nr_of_hits++;
+        value = it->second.value;
+        //Move the expression at the front of the list of the recently used ones
+        lru.splice(lru.begin(),lru,it->second.lru_position);
+    }
+    release();
+
+    return found;
+}
+
+void symoro_par_expression_cache::insert(const char * begin, const char * end, const double value)
+{
+    if( max_nr_of_expressions <= 0 ) return;
+    std::string expression(begin,end);
+
+    acquire();
+    std::map<std::string,cache_entry>::iterator it = entries.find(expression);
+    if( it != entries.end() ) {
+        it->second.value = value;
+        lru.splice(lru.begin(),lru,it->second.lru_position);
+    } else {
+        if( (int)entries.size() == max_nr_of_expressions ) {
+            entries.erase(lru.back());
+            lru.pop_back();
+        }
+        lru.push_front(expression);
+        cache_entry & entry = entries[expression];
+        entry.value = value;
+        entry.lru_position = lru.begin();
+    }
+    release();
+}
+
+void symoro_par_expression_cache::clear()
+{
+    acquire();
+    entries.clear();
+    lru.clear();
+    nr_of_lookups = 0;
+    nr_of_hits = 0;
+    release();
+}
+
+int symoro_par_expression_cache::getNrOfExpressions() const
+{
+    acquire();
+    int nr_of_expressions = entries.size();
+    release();
+    return nr_of_expressions;
+}
+
+long symoro_par_expression_cache::getNrOfLookups() const
+{
+    acquire();
+    long lookups = nr_of_lookups;
+    release();
+    return lookups;
+}
+
+long symoro_par_expression_cache::getNrOfHits() const
+{
+    acquire();
+    long hits = nr_of_hits;
+    release();
+    return hits;
+}
+
+double symoro_par_expression_cache::getHitRate() const
+{
+    acquire();
+    double rate = nr_of_lookups == 0 ? 0.0 : (double)nr_of_hits/nr_of_lookups;
+    release();
+    return rate;
+}
+
+}
@@ -0,0 +1,165 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "kdl_format_io/symoro_par_fk.hpp"
+
+#include <cmath>
+#include <iostream>
+
+using namespace KDL;
+
+namespace kdl_format_io {
+
+symoro_par_fk_solver::symoro_par_fk_solver(const symoro_par_model & par_model):
+    nr_of_dofs(0), valid(false)
+{
+    setModel(par_model);
+}
+
+bool symoro_par_fk_solver::setModel(const symoro_par_model & par_model)
+{
+    valid = false;
+    links.clear();
+    nr_of_dofs = 0;
+
+    if( (par_model.Type != 0 && par_model.Type != 1) || !par_model.isConsistent() ) {
+        std::cerr << "Error: symoro_par_fk_solver supports only consistent SYMORO+ models of Type Tree (1) and Simple Chain (0)" << std::endl;
+        return false;
+    }
+
+    links.resize(par_model.NL);
+    for(int l=0; l < par_model.NL; l++ ) {
+        link_constants & link = links[l];
+
+        //Ant is 1-based (0 is the base): the parent has to precede the link
+        if( par_model.Ant[l] < 0 || par_model.Ant[l] > l ) {
+            std::cerr << "Error: link " << l+1 << " has parent " << par_model.Ant[l] << ", that does not precede it" << std::endl;
+            links.clear();
+            return false;
+        }
+        link.parent = par_model.Ant[l]-1;
+
+        link.sigma = par_model.Sigma[l];
+        if( link.sigma < 0 || link.sigma > 2 ) {
+            std::cerr << "Error: Sigma value not expected"<< std::endl;
+            links.clear();
+            return false;
+        }
+        link.dof = (link.sigma == 2) ? -1 : nr_of_dofs++;
+
+        //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r), see DH_Khalil1986_Tree
+        link.A = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
+                 Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0));
+        link.theta = par_model.Theta[l];
+        link.r = par_model.R[l];
+        link.ct = ::cos(link.theta);
+        link.st = ::sin(link.theta);
+    }
+
+    valid = true;
+    return true;
+}
+
+/**
+ * Compute A*Rot(z,theta)*Trans(z,r), exploiting the structure of Rot(z,theta)
+ */
+static inline void compose_with_z_screw(const Frame & A, const double ct, const double st, const double r, Frame & T)
+{
+    for(int i=0; i < 3; i++ ) {
+        T.M(i,0) =  ct*A.M(i,0) + st*A.M(i,1);
+        T.M(i,1) = -st*A.M(i,0) + ct*A.M(i,1);
+        T.M(i,2) = A.M(i,2);
+        T.p(i) = A.p(i) + r*A.M(i,2);
+    }
+}
+
+bool symoro_par_fk_solver::JntToCart(const double * q, Frame * poses) const
+{
+    if( !valid ) return false;
+
+    Frame T;
+    for(int l=0; l < (int)links.size(); l++ ) {
+        const link_constants & link = links[l];
+        switch( link.sigma ) {
+            case 0:
+            {
+                //Rotational joint, q is added to theta
+                double theta = link.theta + q[link.dof];
+                compose_with_z_screw(link.A,::cos(theta),::sin(theta),link.r,T);
+            }
+            break;
+            case 1:
+                //Prismatic joint, q is added to r
+                compose_with_z_screw(link.A,link.ct,link.st,link.r+q[link.dof],T);
+            break;
+            default:
+                compose_with_z_screw(link.A,link.ct,link.st,link.r,T);
+            break;
+        }
+
+        if( link.parent < 0 ) {
+            poses[l] = T;
+        } else {
+            poses[l] = poses[link.parent]*T;
+        }
+    }
+
+    return true;
+}
+
+bool symoro_par_fk_solver::JntToCart(const std::vector<double> & q, std::vector<Frame> & poses) const
+{
+    if( (int)q.size() != nr_of_dofs ) {
+        std::cerr << "Error: symoro_par_fk_solver expects " << nr_of_dofs << " joint values, got " << q.size() << std::endl;
+        return false;
+    }
+    poses.resize(links.size());
+    if( links.size() == 0 ) return valid;
+    return JntToCart(nr_of_dofs > 0 ? &q[0] : 0,&poses[0]);
+}
+
+bool symoro_par_fk_solver::JntToCartBatch(const double * q, const int nr_of_configurations, Frame * poses) const
+{
+    if( !valid ) return false;
+
+    for(int c=0; c < nr_of_configurations; c++ ) {
+        JntToCart(q+c*nr_of_dofs,poses+c*links.size());
+    }
+
+    return true;
+}
+
+}
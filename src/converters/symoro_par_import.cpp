@@ -35,13 +35,19 @@
 /* Author: Silvio Traversaro */
 
 #include "kdl_format_io/symoro_par_import.hpp"
+#include "kdl_format_io/symoro_par_expression_cache.hpp"
 
 #include "../expression_parser/parser.h"
+#include "symoro_par_tokenizer.hpp"
+#include "numeric_scanner.hpp"
+#include "symoro_par_utils.hpp"
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <utility>
+#include <cstring>
+#include <map>
 #include <kdl/tree.hpp>
 
 using namespace KDL;
@@ -74,14 +80,42 @@ Frame DH_Khalil1986_Tree(double d, double alpha, double r, double theta, double
                      );
 }
 
+/**
+ * Each factor of Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
+ * is a screw motion along an axis that is fixed in the frame of the preceding factors,
+ * so the derivative is the unit twist of that axis, moved to the origin of the child frame
+ */
+Twist DH_Khalil1986_Tree_Derivative(double d, double alpha, double r, double theta, double gamma, double b, const int field)
+{
+    Frame parent_child = DH_Khalil1986_Tree(d,alpha,r,theta,gamma,b);
+    Frame parent_gamma_b = Frame(Rotation::RotZ(gamma),Vector(0,0,b));
+
+    Vector axis;
+    switch( field ) {
+        case symoro_par_model::GAMMA_FIELD:
+            axis = Vector(0,0,1);
+            return Twist(axis*parent_child.p,axis);
+        case symoro_par_model::B_FIELD:
+            return Twist(Vector(0,0,1),Vector::Zero());
+        case symoro_par_model::ALPHA_FIELD:
+            axis = parent_gamma_b.M*Vector(1,0,0);
+            return Twist(axis*(parent_child.p-parent_gamma_b.p),axis);
+        case symoro_par_model::D_FIELD:
+            //Rot(x,alpha) does not change the x axis
+            return Twist(parent_gamma_b.M*Vector(1,0,0),Vector::Zero());
+        case symoro_par_model::R_FIELD:
+            return Twist(parent_child.M*Vector(0,0,1),Vector::Zero());
+    }
+    return Twist::Zero();
+}
+
     
 bool treeFromSymoroParFile(const string& parfile_name, Tree& tree, const bool consider_first_link_inertia)
 {
-    ifstream ifs(parfile_name.c_str());
-    std::string xml_string( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
+    symoro_par_model par_model;
+    if( !parModelFromFile(parfile_name,par_model) ) return false;
 
-    return treeFromSymoroParString(xml_string,tree,consider_first_link_inertia);
+    return treeFromParModel(par_model,tree,consider_first_link_inertia);
 }
 
 bool treeFromSymoroParString(const string& parfile_name, Tree& tree, const bool consider_first_link_inertia)
@@ -94,450 +128,595 @@ bool treeFromSymoroParString(const string& parfile_name, Tree& tree, const bool
 
 
 
-bool parModelFromFile(const string& parfile_name, symoro_par_model& tree)
+bool parModelFromFile(const string& parfile_name, symoro_par_model& tree, symoro_par_expression_cache * expression_cache)
 {
     ifstream ifs(parfile_name.c_str());
-    std::string xml_string( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
+    if( !ifs.is_open() ) {
+        std::cerr << "Error: could not open file " << parfile_name << std::endl;
+        return false;
+    }
 
-    return parModelFromString(xml_string,tree);
+    return parModelFromStream(ifs,tree,expression_cache);
 }
 
 
+std::string int2string(const int in)
+{
+    std::stringstream ss;
+    ss << in;
+    return ss.str();
+}
+
 /**
- * Check if a string contains a substring
+ * Convert a range containing a (possibly signed) integer, fails
+ * if the range contains something else
  */
-bool contains(const std::string & str, const std::string & substr)
+bool range2int(const par_text_range & range, int & ret)
 {
-    return (str.find(substr) != std::string::npos);
+    int val;
+    if( range.empty() || scanInt(range.begin,range.end,val) != range.end ) return false;
+    ret = val;
+    return true;
 }
 
 /**
- * Check if string str start with a given keyword
- * 
+ * Check if a range contains only a symbol name (for example XX3 or D2)
  */
-bool begins_with(const std::string & str, const std::string & keyword)
+bool is_symbol(const par_text_range & range)
 {
-    if( str.size() < keyword.size() ) return false;
-    return( str.substr(0,keyword.size()) == keyword );
-    
+    if( range.empty() ) return false;
+    for(const char * p = range.begin; p < range.end; p++ ) {
+        bool alpha = (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_';
+        bool digit = (*p >= '0' && *p <= '9');
+        if( !alpha && !(digit && p != range.begin) ) return false;
+    }
+    return true;
 }
 
 /**
- * Separate a given string with a given delimitator
- * 
+ * Parse session of a single .par file, filling a symoro_par_model
+ * with the geometric parameters found in the file.
+ *
+ * The session is created once per file: it owns the only Parser used
+ * for all the vectors of the file, and the joint variables t1..tNJ are
+ * bound in the Parser only once, so the work is linear in the file size.
+ *
+ * The numerical elements of all the vectors are compiled as the outputs of
+ * a single Program, so that the constants (as Pi/2) and the subexpressions
+ * that are repeated in the file are computed only once, when all the
+ * program is evaluated at the end of the file by evaluate(). An element
+ * that is repeated in the file is compiled only once, and an element found
+ * in the expression cache (if any) is not compiled at all.
  */
+class symoro_par_parse_session : public symoro_par_statement_handler
+{
+private:
+    symoro_par_model & model;
+
+    //Vector that is currently being filled (only one of them is not NULL)
+    symoro_par_link_field<int> * int_vec;
+    symoro_par_link_field<double> * double_vec;
+
+    //Parser of the mathematical expressions that are allowed in SyMoRo+ par files
+    //The only argument true means that all the unknown variable will be threated as zero
+    Parser prs;
+
+    //Number of joint variables t1..tNJ already bound in prs
+    int nr_of_bound_joint_variables;
+
+    //Program with an output for each distinct numerical element of the file, and the
+    //entries of the model that are set to the value of each output
+    Program program;
+    struct pending_value
+    {
+        symoro_par_link_field<int> * int_vec;
+        symoro_par_link_field<double> * double_vec;
+        int link;
+        int output;
+    };
+    std::vector<pending_value> pending_values;
+
+    //Distinct elements compiled in the program, found by their text with an open addressing
+    //hash table. The texts are copied one after the other in a single string, as the
+    //content of a stream is not kept until the end of the file
+    std::string compiled_texts;
+    struct compiled_element
+    {
+        size_t offset;
+        size_t length;
+        unsigned int hash;
+        int output;
+    };
+    std::vector<compiled_element> compiled_elements;
+    std::vector<int> element_buckets;   ///< index in compiled_elements, -1 if empty
+
+    static unsigned int hashElement(const par_text_range & element)
+    {
+        //FNV-1a
+        unsigned int h = 2166136261u;
+        for(const char * c=element.begin; c != element.end; c++ ) {
+            h = (h ^ (unsigned char)*c)*16777619u;
+        }
+        return h;
+    }
 
-std::vector<std::string> explode(const string& str, const char& ch) {
-    string next;
-    vector<string> result;
-
-    // For each character in the string
-    for (string::const_iterator it = str.begin(); it != str.end(); it++) {
-        // If we've hit the terminal character
-        if (*it == ch) {
-            // If we have some characters accumulated
-            if (!next.empty()) {
-                // Add them to the result vector
-                result.push_back(next);
-                next.clear();
+    /**
+     * Index of the element in compiled_elements, -1 if it was not compiled yet
+     */
+    int findCompiledElement(const par_text_range & element, const unsigned int element_hash) const
+    {
+        size_t length = element.end-element.begin;
+        unsigned int mask = element_buckets.size()-1;
+        for(unsigned int b=element_hash & mask; element_buckets[b] != -1; b = (b+1) & mask ) {
+            const compiled_element & candidate = compiled_elements[element_buckets[b]];
+            if( candidate.hash == element_hash && candidate.length == length &&
+                memcmp(compiled_texts.data()+candidate.offset,element.begin,length) == 0 ) {
+                return element_buckets[b];
             }
-        } else {
-            // Accumulate the next character into the sequence
-            next += *it;
         }
+        return -1;
     }
-    if (!next.empty())
-         result.push_back(next);
-    return result;
-}
 
-/*
-std::vector<std::string> explode(std::string const & s, char delim)
-{
-    std::vector<std::string> result;
-    std::istringstream iss(s);
+    void addCompiledElement(const par_text_range & element, const unsigned int element_hash, const int output)
+    {
+        compiled_element compiled;
+        compiled.offset = compiled_texts.size();
+        compiled.length = element.end-element.begin;
+        compiled.hash = element_hash;
+        compiled.output = output;
+        compiled_texts.append(element.begin,element.end);
+        compiled_elements.push_back(compiled);
+
+        //Keep the load factor of the table below one half
+        if( 2*compiled_elements.size() > element_buckets.size() ) {
+            element_buckets.assign(2*element_buckets.size(),-1);
+            for(size_t e=0; e+1 < compiled_elements.size(); e++ ) insertBucket(e);
+        }
+        insertBucket(compiled_elements.size()-1);
+    }
+
+    void insertBucket(const int e)
+    {
+        unsigned int mask = element_buckets.size()-1;
+        unsigned int b = compiled_elements[e].hash & mask;
+        while( element_buckets[b] != -1 ) b = (b+1) & mask;
+        element_buckets[b] = e;
+    }
+
+    //Cache shared with the imports of other files, can be NULL
+    symoro_par_expression_cache * expression_cache;
+
+    //Field currently being filled, if the current vector can contain symbolic parameters (-1 otherwise)
+    int symbolic_field;
+
+    //Parameter table of the current vector (inertial or geometric)
+    std::vector<std::string> * symbolic_names;
+    std::vector<symoro_par_symbolic_entry> * symbolic_entries;
+    std::map<std::string,int> * symbolic_ids;
+
+    //Index of each symbolic parameter in model.inertial_parameter_names and model.geometric_parameter_names
+    std::map<std::string,int> inertial_parameter_ids;
+    std::map<std::string,int> geometric_parameter_ids;
+
+    //Name of the last free symbol found in an element, reused to avoid allocations
+    std::string free_symbol;
+
+    /**
+     * Find the first symbol of an expression that is not known to the parser (so it is a
+     * symbolic parameter), skipping the names of the functions and the constants E and PI
+     * returns true if a symbol is found, storing its name in symbol
+     */
+    bool findFreeSymbol(const par_text_range & element, std::string & symbol) const
+    {
+        const char * p = element.begin;
+        while( p < element.end ) {
+            bool alpha = (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_';
+            if( !alpha ) {
+                //The digits, and the exponents of the numbers, are not part of a symbol
+                if( (*p >= '0' && *p <= '9') || *p == '.' ) {
+                    double number;
+                    const char * number_end = scanDouble(p,element.end,number);
+                    p = number_end > p ? number_end : p+1;
+                } else {
+                    p++;
+                }
+                continue;
+            }
+            const char * name_begin = p;
+            while( p < element.end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_' || (*p >= '0' && *p <= '9')) ) p++;
+            const char * after_name = p;
+            while( after_name < element.end && (*after_name == ' ' || *after_name == '\t') ) after_name++;
+            if( after_name < element.end && *after_name == '(' ) continue;
+
+            symbol.assign(name_begin,p);
+            if( Variablelist::equals_no_case(symbol.c_str(),"E") || Variablelist::equals_no_case(symbol.c_str(),"PI") ) continue;
+            if( !prs.user_var.exist(symbol.c_str()) ) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Add to the model an entry of the current vector that is defined by the symbolic parameter symbol
+     */
+    void addSymbolicEntry(const std::string & symbol)
+    {
+        std::pair<std::map<std::string,int>::iterator,bool> ins =
+            symbolic_ids->insert(std::make_pair(symbol,(int)symbolic_names->size()));
+        if( ins.second ) symbolic_names->push_back(ins.first->first);
+
+        symoro_par_symbolic_entry entry;
+        entry.link = (int)double_vec->size();
+        entry.field = symbolic_field;
+        entry.parameter = ins.first->second;
+        symbolic_entries->push_back(entry);
+    }
 
-    for (std::string token; std::getline(iss, token, delim); )
+    /**
+     * In SyMoRo par file, for Theta is reported all the expression, so
+     * if the offset is 0.2 for the frist joint, it will report t1+0.2
+     * We are interested only on the offset so we put all this variable to 0
+     * to obtain only the offset
+     */
+    void bindJointVariables()
     {
-        result.push_back(std::move(token));
+        for(int j=nr_of_bound_joint_variables+1; j <= model.NJ; j++ ) {
+            std::string var_name = "t" + int2string(j);
+            prs.user_var.add(var_name.c_str(),0.0);
+        }
+        if( model.NJ > nr_of_bound_joint_variables ) nr_of_bound_joint_variables = model.NJ;
     }
 
-    return result;
-}*/
+public:
+    symoro_par_parse_session(symoro_par_model & _model, symoro_par_expression_cache * _expression_cache):
+        model(_model), int_vec(0), double_vec(0), prs(true), nr_of_bound_joint_variables(0),
+        expression_cache(_expression_cache),
+        symbolic_field(-1), symbolic_names(0), symbolic_entries(0), symbolic_ids(0)
+    {
+        element_buckets.assign(64,-1);
+        model.geometric_parameter_names.resize(0);
+        model.geometric_entries.resize(0);
+        model.inertial_parameter_names.resize(0);
+        model.inertial_entries.resize(0);
+    }
+
+    bool scalar(const par_text_range & name, const par_text_range & value)
+    {
+        if( name.equals("NL") ) return range2int(value,model.NL);
+        if( name.equals("NJ") ) {
+            if( !range2int(value,model.NJ) ) return false;
+            bindJointVariables();
+            return true;
+        }
+        if( name.equals("NF") ) return range2int(value,model.NF);
+        if( name.equals("Type") ) return range2int(value,model.Type);
+        return true;
+    }
+
+    bool vectorBegin(const par_text_range & name, bool & skip)
+    {
+        int_vec = 0;
+        double_vec = 0;
+        symbolic_field = -1;
+
+        //Depending on the param, we expect a vector of double or integers
+        if( name.equals("Ant") ) { int_vec = &model.Ant; }
+        else if( name.equals("Sigma") ) { int_vec = &model.Sigma; }
+        else if( name.equals("Mu") ) { int_vec = &model.Mu; }
+        else if( name.equals("Theta") ) { double_vec = &model.Theta; }
+        else {
+            //Vectors that can contain symbolic parameters
+            for(int f=0; f < symoro_par_model::NR_OF_GEOMETRIC_FIELDS && !double_vec; f++ ) {
+                if( name.equals(symoro_par_model::geometricFieldName(f)) ) {
+                    double_vec = &model.geometricField(f);
+                    symbolic_field = f;
+                    symbolic_names = &model.geometric_parameter_names;
+                    symbolic_entries = &model.geometric_entries;
+                    symbolic_ids = &geometric_parameter_ids;
+                }
+            }
+            for(int f=0; f < symoro_par_model::NR_OF_INERTIAL_FIELDS && !double_vec; f++ ) {
+                if( name.equals(symoro_par_model::inertialFieldName(f)) ) {
+                    double_vec = &model.inertialField(f);
+                    symbolic_field = f;
+                    symbolic_names = &model.inertial_parameter_names;
+                    symbolic_entries = &model.inertial_entries;
+                    symbolic_ids = &inertial_parameter_ids;
+                }
+            }
+        }
+
+        skip = (int_vec == 0 && double_vec == 0);
+        if( skip ) return true;
+
+        //Per-link vectors have NL elements, that are stored in place in the
+        //single allocation of the model, reserved once for all the vectors
+        model.reserveLinks(model.NL);
+        if( int_vec ) int_vec->resize(0);
+        if( double_vec ) double_vec->resize(0);
+
+        return true;
+    }
+
+    bool vectorElement(const par_text_range & element)
+    {
+        //Vectors longer than NL (not consistent) need more storage
+        int size = int_vec ? int_vec->size() : double_vec->size();
+        if( size == model.getNrOfReservedLinks() ) model.reserveLinks(2*size+1);
+
+        //Symbolic parameters are kept as parameter slots, with value 0 until they are bound.
+        //Only bare parameters are supported: an expression of a parameter (as -D3 or 2*D3)
+        //would be silently evaluated with the parameter equal to 0
+        if( symbolic_field >= 0 && findFreeSymbol(element,free_symbol) ) {
+            if( !is_symbol(element) ) {
+                std::cerr << "Error: the symbolic parameter " << free_symbol << " is used in the expression " << element.str()
+                          << ", only bare symbolic parameters are supported" << std::endl;
+                return false;
+            }
+            addSymbolicEntry(free_symbol);
+            double_vec->push_back(0.0);
+            return true;
+        }
+
+        double cached_value;
+        if( expression_cache && expression_cache->lookup(element.begin,element.end,cached_value) ) {
+            if( int_vec ) int_vec->push_back((int)cached_value);
+            if( double_vec ) double_vec->push_back(cached_value);
+            return true;
+        }
+
+        //The expression is compiled in place, without copying it, and its value is set by evaluate()
+        unsigned int element_hash = hashElement(element);
+        int compiled = findCompiledElement(element,element_hash);
+        int output;
+        if( compiled >= 0 ) {
+            output = compiled_elements[compiled].output;
+        } else {
+            output = program.get_nr_of_outputs();
+            ErrorStatus status;
+            if( !prs.compile_output(element.begin,element.end,program,status) ) {
+                std::cerr << "Error: could not parse " << element.str() << " : " << status.msg << std::endl;
+                return false;
+            }
+            addCompiledElement(element,element_hash,output);
+        }
+
+        pending_value pending;
+        pending.int_vec = int_vec;
+        pending.double_vec = double_vec;
+        pending.link = size;
+        pending.output = output;
+        pending_values.push_back(pending);
+
+        if( int_vec ) int_vec->push_back(0);
+        if( double_vec ) double_vec->push_back(0.0);
+        return true;
+    }
+
+    bool vectorEnd()
+    {
+        symbolic_field = -1;
+        int_vec = 0;
+        double_vec = 0;
+        return true;
+    }
+
+    /**
+     * Evaluate the numerical elements of the file, to be called after the last statement
+     */
+    bool evaluate()
+    {
+        if( pending_values.empty() ) return true;
+
+        ErrorStatus status;
+        std::vector<double> values(program.get_nr_of_outputs());
+        if( !prs.eval(program,&values[0],status) ) {
+            std::cerr << "Error: could not evaluate the elements of the .par file : " << status.msg << std::endl;
+            return false;
+        }
+
+        for(size_t i=0; i < pending_values.size(); i++ ) {
+            const pending_value & pending = pending_values[i];
+            if( pending.int_vec ) (*pending.int_vec)[pending.link] = (int)values[pending.output];
+            if( pending.double_vec ) (*pending.double_vec)[pending.link] = values[pending.output];
+        }
+
+        if( expression_cache ) {
+            for(size_t i=0; i < compiled_elements.size(); i++ ) {
+                const char * text = compiled_texts.data()+compiled_elements[i].offset;
+                expression_cache->insert(text,text+compiled_elements[i].length,values[compiled_elements[i].output]);
+            }
+        }
+        return true;
+    }
+};
 
 /**
- * Convert a string to a double
+ * Parse the content of a .par file with a single pass over the
+ * (unmodified) content, without intermediate copies.
+ *
+ * In Symoro+ the parameters can be specified as a numerical value (or a formula of numerical values)
+ * or as a symbolic name. This parse support only the import of numerical values or simple formulas, and
+ * only the importation of geometric parameters of chain or tree structures
  */
-double str2double(const std::string & str)
+bool parModelFromString(const string& parfile_content, symoro_par_model & model, symoro_par_expression_cache * expression_cache)
 {
-    double ret;
-    std::istringstream ss(str);
-    ss >> ret;
-    return ret;
+    symoro_par_parse_session session(model,expression_cache);
+    const char * begin = parfile_content.data();
+    return tokenizeSymoroPar(begin,begin+parfile_content.size(),session) && session.evaluate();
 }
 
-std::string int2string(const int in)
+bool parModelFromStream(std::istream& parfile_stream, symoro_par_model & model, symoro_par_expression_cache * expression_cache)
 {
-    std::stringstream ss;
-    ss << in;
-    return ss.str();
-}
+    symoro_par_parse_session session(model,expression_cache);
+    symoro_par_tokenizer tokenizer(session);
+
+    //The buffer contains the unconsumed part of the previous chunk followed by the new one,
+    //it grows only if a single definition does not fit in it
+    std::vector<char> buffer(4096);
+    size_t pending = 0;
+    bool last = false;
+
+    while( !last ) {
+        parfile_stream.read(&buffer[pending],buffer.size()-pending);
+        size_t available = pending + parfile_stream.gcount();
+        last = !parfile_stream;
+        if( last && parfile_stream.bad() ) {
+            std::cerr << "Error: could not read the .par file" << std::endl;
+            return false;
+        }
 
+        size_t consumed = 0;
+        if( !tokenizer.feed(&buffer[0],&buffer[0]+available,last,consumed) ) return false;
 
+        pending = available-consumed;
+        if( pending > 0 ) memmove(&buffer[0],&buffer[consumed],pending);
+        if( pending == buffer.size() ) buffer.resize(2*buffer.size());
+    }
 
+    return session.evaluate();
+}
 
 /**
- * Convert a string containing a declaration of a vector of T
- * in a std::vector<T>. Fails if the expression contains a unknown variable 
- * or constant. 
+ * Convert the inertial parameters of link l, expressed in the SyMoRo convention
+ * (inertia and first moment of inertia with respect to the link frame origin)
+ * to a KDL::RigidBodyInertia. Returns a zero inertia if the model has no inertial parameters.
  */
-template <class T>
-bool extract_vector(const std::string & vector_string, std::string vector_name, std::vector<T> & vec, const std::vector<string> variables=std::vector<string>(0), const std::vector<T> var_values=std::vector<T>(0))
+RigidBodyInertia parLinkInertia(const symoro_par_model & par_model, const int l)
 {
-    if( variables.size() != var_values.size() ) return false;
-    if( !contains(vector_string,"={") || !contains(vector_string,"}") ) return false;
-    
-    
-    //Get position of =,{,}
-    int eq_pos, open_pos, close_pos;
-    eq_pos = vector_string.find("=");
-    open_pos = vector_string.find("{");
-    close_pos = vector_string.find("}",open_pos+1);
-    
-    vector_name = vector_string.substr(0,eq_pos);
-   
-    
-    //Extracting the list of elements of the vector
-    std::string vector_elems_string = vector_string.substr(open_pos+1,close_pos-open_pos-1);
-    
-    
-    std::vector<string> vector_elems_strs = explode(vector_elems_string,',');
-   
-    
-    //Create the parser object that is need to parse the mathematical expression that are allowed in SyMoRo+ par files
-    //The only argument true means that all the unknown variable will be threated as zero
-    Parser prs(true);
-    
-    //Add the user defined variable (E/e and Pi/pi/PI are already defined in the Parser)
-    for(int i=0; i < variables.size(); i++ ) {
-        bool check = prs.user_var.add(variables[i].c_str(),(double)var_values[i]);
-        if( !check ) return false;
-    }  
-    
-    //Then we parse the expression in the vector
-    vec.resize(vector_elems_strs.size());
-    
-    for(int i=0; i < vector_elems_strs.size(); i++ ) {
-        char * res;
-        //std::cout << "Called parser with " << vector_elems_strs[i] << std::endl;
-        res = prs.parse(vector_elems_strs[i].c_str());
-        //printf("\t%s\t",res);
-        //the +6 is to avoid the "Ans = " par of the result
-        std::string res_cpp(res+6);
-        //std::cout << "returning " << res_cpp << std::endl;
-        vec[i] = (T)str2double(res_cpp);
-        //std::cout << "Set in vector " << vec[i] << " ( " << str2double(res_cpp) << " ) " << std::endl;
-    }
-    
-    return true;
+    if( !par_model.hasInertialParameters() ) return RigidBodyInertia::Zero();
+
+    double mass = par_model.M[l];
+    if( mass == 0.0 ) return RigidBodyInertia::Zero();
+
+    Vector com = Vector(par_model.MX[l],par_model.MY[l],par_model.MZ[l])/mass;
+
+    //Inertia with respect to the center of mass: I_c = I_o + m*(c*c^T - (c^T*c)*1)
+    double cc = dot(com,com);
+    RotationalInertia I_com(par_model.XX[l] + mass*(com(0)*com(0)-cc),
+                            par_model.YY[l] + mass*(com(1)*com(1)-cc),
+                            par_model.ZZ[l] + mass*(com(2)*com(2)-cc),
+                            par_model.XY[l] + mass*com(0)*com(1),
+                            par_model.XZ[l] + mass*com(0)*com(2),
+                            par_model.YZ[l] + mass*com(1)*com(2));
+
+    return RigidBodyInertia(mass,com,I_com);
 }
 
 /**
- * 
- * \todo add formula parsing
+ * Build the segment of link l of a par model, attached to its parent link (par_model.Ant[l]).
+ * For chains (Type 0) the model is consistent only if gamma and b are 0, so the same
+ * expressions are valid for both chains and trees.
  */
-bool parModelFromString(const string& _parfile_content, symoro_par_model & model)
+bool parLinkSegment(const symoro_par_model& par_model, const int l,
+                    const std::string & link_name, const std::string & joint_name,
+                    const RigidBodyInertia & inertia, Segment & segment)
 {
-   std::string parfile_content = _parfile_content;
-    
-    //Custom parser just to avoid adding another depencency on some fancy string manipulator/parser
-    
-    //Remove spaces and tabs (and CR) as they are not relevant to the contents of the file
-    parfile_content.erase(std::remove(parfile_content.begin(), parfile_content.end(), ' '), parfile_content.end());
-    parfile_content.erase(std::remove(parfile_content.begin(), parfile_content.end(), '\t'), parfile_content.end());
-    parfile_content.erase(std::remove(parfile_content.begin(), parfile_content.end(), '\r'), parfile_content.end());
-    
-    //Create a string stream object to iterate line after line
-    istringstream iss(parfile_content);
-    
-    std::string line;    
-    while (std::getline(iss, line)) {
-        //Condition for which ignore the line
-        if( line.size() == 0 ) { continue; } //empty line
-        if( line.substr(2) == "(*" ) { continue; } //comment line
-        
-        //In all other case, the line (and possibile the following lines) contain a variable definition
-        //In Symoro+ the parameters can be specified as a numerical value (or a formula of numerical values)
-        //or as a symbolic name. This parse support only the import of numerical values or simple formulas, and
-        //only the importation of geometric parameters of chain or tree structures
-        if( contains(line,"=") ) {
-            if( begins_with(line,"NL") ) {
-                stringstream ss(line.substr(3,line.size()-3));
-                ss >> model.NL;
-                continue;
-            }
-            if( begins_with(line,"NJ") ) {
-                stringstream ss(line.substr(3,line.size()-3));
-                ss >> model.NJ;
-                continue;
-            }
-            if( begins_with(line,"NF") ) {
-                stringstream ss(line.substr(3,line.size()-3));
-                ss >> model.NF;
-                continue;
-            }
-            if( begins_with(line,"Type") ) {
-                stringstream ss(line.substr(5,1));
-                ss >> model.Type;
-                continue;
-            }
+    //The parameters use the convention explained in Khalil 1986
+    Frame f_parent_child = DH_Khalil1986_Tree(par_model.d[l],
+                                              par_model.Alpha[l],
+                                              par_model.R[l],
+                                              par_model.Theta[l],
+                                              par_model.gamma[l],
+                                              par_model.B[l]);
+
+    switch( par_model.Sigma[l] ) {
+        case 0:
+        {
+            //Rotational joint
+            //The parameters use the convention explained in Khalil 1986
+            //The transformation matrix used in symoro is T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
+            //That can be factorized to fit in Segment RotAxis model (theta is the joint variable)  as:
+            //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(x,-d)*Rot(x,-alpha)*Trans(z,-b)*Rot(z,-gamma)*Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Trans(z,r)
+            Frame new_old_axis_ref_frame = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
+                                           Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0));
+            Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
+            Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
+            segment = Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::RotAxis),f_parent_child,inertia);
         }
-        
-        //Vector definition
-        std::string all_vector = "";
-        std::string vector_new_line;
-        std::vector<int> int_vec(0);
-        std::vector<double> double_vec(0);
-        if( contains(line,"={") ) {
-            if( contains(line,"}") ) {
-                //This if the vector is in the same line of the declaration
-                all_vector = line;
-            } else {
-                all_vector = line;
-                //Otherwise get all the lines over which the vector spans
-                while (std::getline(iss, vector_new_line)) {
-                    all_vector = all_vector+vector_new_line;
-                    if( contains(vector_new_line,"}") ) break;
-                }
-            }
-            
-            std::string dummy_name;
-            //At this point, all_vector contains a string that inside contains the vector
-            //Depending on the param, we expect a vector of double or integers
-            if( begins_with(all_vector,"Ant") ) {
-                if( !extract_vector<int>(all_vector,dummy_name,int_vec) ) return false;
-                model.Ant = int_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"Sigma") ) {
-                if( !extract_vector<int>(all_vector,dummy_name,int_vec) ) return false;
-                model.Sigma = int_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"Mu") ) {
-                if( !extract_vector<int>(all_vector,dummy_name,int_vec) ) return false;
-                model.Mu = int_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"B") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec) ) return false;
-                model.B = double_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"d") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec) ) return false;
-                model.d = double_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"R") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec) ) return false;
-                model.R = double_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"gamma") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec) ) return false;
-                model.gamma = double_vec;
-                continue;
-            }
-            
-            if( begins_with(all_vector,"Alpha") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec) ) return false;
-                model.Alpha = double_vec;
-                continue;
-            }
-            
-            //In SyMoRo par file, for Theta is reported all the expression, so 
-            //if the offset is 0.2 for the frist joint, it will report t1+0.2
-            //We are interested only on the offset so we put all this variable to 0
-            //to obtain only the offset
-            std::vector<std::string> Theta_var(model.NJ);
-            std::vector<double> Theta_var_values(model.NJ);
-            for(int j=1; j <= model.NJ; j++ ) {
-                std::string j_str = int2string(j);
-                Theta_var[j-1] = "t" + j_str;
-                Theta_var_values[j-1] = 0.0;
-            }
-            
-            if( begins_with(all_vector,"Theta") ) {
-                if( !extract_vector<double>(all_vector,dummy_name,double_vec,Theta_var,Theta_var_values) ) return false;
-                model.Theta = double_vec;
-                continue;
-            }
-        
+        break;
+        case 1:
+        {
+            //Prismatic joint
+            //The parameters use the convention explained in Khalil 1986
+            //The transformation matrix used in symoro is T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
+            //That can be factorized to fit in Segment TransAxis model (r is the joint variable)  as:
+            //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)*Rot(z,-theta)*Trans(x,-d)*Rot(x,-alpha)*Trans(z,-b)*Rot(z,-gamma)*Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)
+            Frame new_old_axis_ref_frame = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
+                                           Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0))*Frame(Rotation::RotZ(par_model.Theta[l]));
+            Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
+            Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
+            segment = Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::TransAxis),f_parent_child,inertia);
         }
+        break;
+        case 2:
+            //Fixed joint
+            segment = Segment(link_name,Joint(joint_name,Joint::None),f_parent_child,inertia);
+        break;
+        default:
+            std::cerr << "Error: Sigma value not expected"<< std::endl; return false;
+        break;
     }
-    
+
     return true;
 }
 
-bool treeFromParModelTree(const symoro_par_model& par_model, Tree& tree, const bool consider_first_link_inertia)
+void parModelNames(const symoro_par_model& par_model, const bool consider_first_link_inertia, symoro_par_names & names)
 {
-    const std::string base_name = "Link0";
-    tree = Tree(base_name);
-    //As the SYMORO .par doesn't support names for link and joints, the links will be named Link1, Link2, and joints Joint1, Joint2
     const std::string link_common_name = "Link";
     const std::string joint_common_name = "Joint";
-    
-    std::vector<std::string> link_names(par_model.NL+1);
-    std::vector<std::string> joint_names(par_model.NJ+1);
-    
-    link_names[0] = base_name;
-    joint_names[0] = "joint_not_existing";
-    
+
+    names.link_names.resize(par_model.NL+1);
+    names.joint_names.resize(par_model.NL);
+
+    names.link_names[0] = link_common_name + "0";
     for(int l=0; l < par_model.NL; l++ ) {
-        std::string link_name = link_common_name + int2string(l+1);
-        std::string joint_name = joint_common_name + int2string(l+1);
-        link_names[l+1] = link_name;
-        joint_names[l+1] = joint_name;
-        std::string precessor_link_name = link_names[par_model.Ant[l]];
-        if( par_model.Sigma[l] != 0 ) { std::cerr << "Warning: only rotational joint are currently tested" << std::endl; }
-        
-        //The parameters use the convention explained in Khalil 1986
-        Frame f_parent_child = DH_Khalil1986_Tree(par_model.d[l],
-                                                  par_model.Alpha[l],
-                                                  par_model.R[l],
-                                                  par_model.Theta[l],
-                                                  par_model.gamma[l],
-                                                  par_model.B[l]);
-        
-        
-                                                 
-        switch( par_model.Sigma[l] ) {
-            case 0:
-            {
-                //Rotational joint 
-                //The parameters use the convention explained in Khalil 1986
-                //The transformation matrix used in symoro is T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
-                //That can be factorized to fit in Segment RotAxis model (theta is the joint variable)  as: 
-                //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(x,-d)*Rot(x,-alpha)*Trans(z,-b)*Rot(z,-gamma)*Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Trans(z,r)
-                Frame new_old_axis_ref_frame = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
-                                               Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0));
-                Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
-                Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
-                tree.addSegment(Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::RotAxis),f_parent_child),precessor_link_name);
-            }
-            break;
-            case 1:
-            {
-                //Prismatic joint
-               //The parameters use the convention explained in Khalil 1986
-                //The transformation matrix used in symoro is T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
-                //That can be factorized to fit in Segment RotAxis model (theta is the joint variable)  as: 
-                //T_parent_child = Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)*Rot(z,-theta)*Trans(x,-d)*Rot(x,-alpha)*Trans(z,-b)*Rot(z,-gamma)*Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)               
-                
-                Frame new_old_axis_ref_frame = Frame(Rotation::RotZ(par_model.gamma[l]))*Frame(Vector(0,0,par_model.B[l]))*
-                                               Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0))*Frame(Rotation::RotZ(par_model.Theta[l]));                
-                Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
-                Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
-                tree.addSegment(Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::TransAxis),f_parent_child),precessor_link_name);
-            }
-            break;
-            case 2: 
-                //Fixed joint
-                tree.addSegment(Segment(link_name,Joint(joint_name,Joint::None),f_parent_child),precessor_link_name);
-            break;
-            default:
-            std::cerr << "Error: Sigma value not expected"<< std::endl; return false;
-            break;
-        }
-        
-       
+        names.link_names[l+1] = link_common_name + int2string(l+1);
+    }
+
+    //Joints of chains are numbered from 0, joints of trees from 1
+    int joint_offset = (par_model.Type == 0) ? 0 : 1;
+    for(int l=0; l < par_model.NL; l++ ) {
+        names.joint_names[l] = joint_common_name + int2string(l+joint_offset);
+    }
+
+    //For chains, a fake base is introduced to overcome the the fact that KDL does not support inertia in the first link
+    names.has_fake_base = (par_model.Type == 0 && consider_first_link_inertia);
+    if( names.has_fake_base ) {
+        names.root_name = "FakeBase_introduced_by_symoro_par_import";
+        names.fake_base_joint_name = "FakeFixedJoint_introduced_by_symoro_par_import";
+    } else {
+        names.root_name = names.link_names[0];
+        names.fake_base_joint_name = "";
     }
-    return true;
-    
 }
 
-bool treeFromParModelChain(const symoro_par_model& par_model, Tree& tree, const bool consider_first_link_inertia)
+bool parAddLinkToTree(const symoro_par_model& par_model, const symoro_par_names & names, const int l, Tree& tree)
 {
+    if( par_model.Ant[l] < 0 || par_model.Ant[l] > l ) { std::cerr << "Error in the structure of par tree" << std::endl; return false; }
+    if( par_model.Type == 0 && par_model.Ant[l] != l ) { std::cerr << "Error in the structure of par chain" << std::endl; return false; }
+    if( par_model.Type == 1 && par_model.Sigma[l] != 0 ) { std::cerr << "Warning: only rotational joint are currently tested" << std::endl; }
 
-    //As the SYMORO .par doesn't support names for link and joints, the links will be named Link1, Link2, and joints Joint1, Joint2
-    const std::string link_common_name = "Link";
-    const std::string joint_common_name = "Joint";
-    
-    const std::string base_name = link_common_name + int2string(0);
-    if( !consider_first_link_inertia ) {
-        tree = Tree(base_name);
-    } else {
-        const std::string fake_base_name = "FakeBase_introduced_by_symoro_par_import";
-        tree = Tree(fake_base_name);
-        tree.addSegment(Segment(base_name,Joint("FakeFixedJoint_introduced_by_symoro_par_import",Joint::None)),fake_base_name);
+    Segment segment;
+    if( !parLinkSegment(par_model,l,names.link_names[l+1],names.joint_names[l],parLinkInertia(par_model,l),segment) ) return false;
+    if( !tree.addSegment(segment,names.link_names[par_model.Ant[l]]) ) { std::cerr << "Error in the structure of par tree" << std::endl; return false; }
+    return true;
+}
+
+void parCreateTreeRoot(const symoro_par_names & names, Tree& tree)
+{
+    tree = Tree(names.root_name);
+    if( names.has_fake_base ) {
+        tree.addSegment(Segment(names.link_names[0],Joint(names.fake_base_joint_name,Joint::None)),names.root_name);
     }
-    
-    std::vector<std::string> link_names(par_model.NL+1);
-    std::vector<std::string> joint_names(par_model.NJ+1);
-    
-    link_names[0] = base_name;
-    joint_names[0] = "joint_not_existing";
-    
+}
+
+bool treeFromParModelNames(const symoro_par_model& par_model, const symoro_par_names & names, Tree& tree)
+{
+    parCreateTreeRoot(names,tree);
     for(int l=0; l < par_model.NL; l++ ) {
-        std::string link_name = link_common_name + int2string(l+1);
-        std::string joint_name = joint_common_name + int2string(l);
-        link_names[l+1] = link_name;
-        joint_names[l+1] = joint_name;
-        std::string precessor_link_name = link_names[par_model.Ant[l]];
-        if( par_model.Ant[l] != l ) { std::cerr << "Error in the structure of par chain" << std::endl; return false; }        
-        Frame f_parent_child = DH_Khalil1986_Tree(par_model.d[l],
-                                                  par_model.Alpha[l],
-                                                  par_model.R[l],
-                                                  par_model.Theta[l],
-                                                  0,
-                                                  0);
-        switch( par_model.Sigma[l] ) {
-            case 0:
-            {
-                //Rotational joint 
-                //The parameters use the convention explained in Khalil 1986
-                //The transformation matrix used in symoro is T_parent_child = Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
-                //That can be factorized to fit in Segment RotAxis Joint model (theta is the joint variable) as: 
-                //T_parent_child = Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(x,-d)*Rot(x,-alpha)*Rot(x,alpha)*Trans(x,d)*Trans(z,r)
-                Frame new_old_axis_ref_frame = Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0));
-                Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
-                Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
-                tree.addSegment(Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::RotAxis),f_parent_child),precessor_link_name);
-            }
-            break;
-            case 1:
-            {
-                //Prismatic joint
-                //The parameters use the convention explained in Khalil 1986
-                //The transformation matrix used in symoro is T_parent_child = Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
-                //That can be factorized to fit in Segment TransAxis Joint model (r is the joint variable) as: 
-                //T_parent_child = Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)*Rot(z,-theta)*Trans(x,-d)*Rot(x,-alpha)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)
-                Frame new_old_axis_ref_frame = Frame(Rotation::RotX(par_model.Alpha[l]))*Frame(Vector(par_model.d[l],0,0))*Frame(Rotation::RotZ(par_model.Theta[l]));
-                Vector jnt_axis_parent = new_old_axis_ref_frame.M*Vector(0,0,1);
-                Vector jnt_origin_parent = new_old_axis_ref_frame*Vector(0,0,0);
-                tree.addSegment(Segment(link_name,Joint(joint_name,jnt_origin_parent,jnt_axis_parent,Joint::TransAxis),f_parent_child),precessor_link_name);
-            }
-            break;
-            case 2: 
-                //Fixed joint
-                tree.addSegment(Segment(link_name,Joint(joint_name,Joint::None),f_parent_child),precessor_link_name);
-            break;
-            default:
-            std::cerr << "Error: Sigma value not expected"<< std::endl; return false;
-            break;
-        }
-            
+        if( !parAddLinkToTree(par_model,names,l,tree) ) return false;
     }
     return true;
-    
 }
 
 bool treeFromParModel(const symoro_par_model& par_model, Tree& tree, const bool consider_first_link_inertia)
@@ -552,12 +731,160 @@ bool treeFromParModel(const symoro_par_model& par_model, Tree& tree, const bool
         return false;
     }
     
-    if( par_model.Type == 1 ) return treeFromParModelTree(par_model,tree,consider_first_link_inertia);
-    if( par_model.Type == 0 ) return treeFromParModelChain(par_model,tree,consider_first_link_inertia);
+    if( par_model.Type == 1 || par_model.Type == 0 ) {
+        symoro_par_names names;
+        parModelNames(par_model,consider_first_link_inertia,names);
+        return treeFromParModelNames(par_model,names,tree);
+    }
    
     std::cerr << "Error: currently are only supported SYMORO+ .par files of Type Tree (1) and Simple Chain (0)" << std::endl;
     return false;
 }
 
+bool parTreeNames(const symoro_par_model& par_model, const Tree& tree, symoro_par_names & names)
+{
+    //Only chains built with consider_first_link_inertia have a fake base as root
+    parModelNames(par_model,true,names);
+    if( tree.getRootSegment()->first != names.root_name ) parModelNames(par_model,false,names);
+
+    int nr_of_segments = par_model.NL + (names.has_fake_base ? 1 : 0);
+    if( tree.getRootSegment()->first != names.root_name || (int)tree.getNrOfSegments() != nr_of_segments ) {
+        std::cerr << "Error: the tree was not created from the SYMORO par model" << std::endl;
+        return false;
+    }
+    for(int l=0; l < par_model.NL; l++ ) {
+        if( tree.getSegment(names.link_names[l+1]) == tree.getSegments().end() ) {
+            std::cerr << "Error: tree does not contain the segment of link " << l+1 << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool treeFromParModelTemplate(const symoro_par_model& par_model, const symoro_par_names & names, const Tree & template_tree,
+                              const std::vector<bool> & rebuilt_links, const std::vector<bool> & refreshed_inertia, Tree& tree)
+{
+    //KDL::Tree does not allow to replace a segment, so the tree is filled again in the order
+    //of the links (the parent of a link always precedes it), copying the unchanged segments
+    parCreateTreeRoot(names,tree);
+    for(int l=0; l < par_model.NL; l++ ) {
+        SegmentMap::const_iterator old_segment = template_tree.getSegment(names.link_names[l+1]);
+        if( old_segment == template_tree.getSegments().end() ) {
+            std::cerr << "Error: tree does not contain the segment of link " << l+1 << std::endl;
+            return false;
+        }
+        const Segment & template_segment = old_segment->second.segment;
+        bool rebuilt = !rebuilt_links.empty() && rebuilt_links[l];
+        bool refreshed = !refreshed_inertia.empty() && refreshed_inertia[l];
+
+        Segment segment;
+        if( rebuilt ) {
+            RigidBodyInertia inertia = refreshed ? parLinkInertia(par_model,l) : template_segment.getInertia();
+            if( !parLinkSegment(par_model,l,names.link_names[l+1],names.joint_names[l],inertia,segment) ) return false;
+        } else {
+            segment = template_segment;
+            if( refreshed ) segment.setInertia(parLinkInertia(par_model,l));
+        }
+        if( !tree.addSegment(segment,names.link_names[par_model.Ant[l]]) ) { std::cerr << "Error in the structure of par tree" << std::endl; return false; }
+    }
+    return true;
+}
+
+bool bindGeometricParameters(symoro_par_model& par_model, const std::vector<double>& values, Tree& tree)
+{
+    if( values.size() != par_model.geometric_parameter_names.size() ) {
+        std::cerr << "Error: expected " << par_model.geometric_parameter_names.size() << " geometric parameters, got " << values.size() << std::endl;
+        return false;
+    }
+
+    //Check the tree before modifying the model
+    symoro_par_names names;
+    if( !parTreeNames(par_model,tree,names) ) return false;
+
+    //Write the values in all the entries that use a symbolic parameter
+    for(int e=0; e < (int)par_model.geometric_entries.size(); e++ ) {
+        const symoro_par_symbolic_entry & entry = par_model.geometric_entries[e];
+        if( par_model.Type == 0 && (entry.field == symoro_par_model::B_FIELD || entry.field == symoro_par_model::GAMMA_FIELD)
+            && values[entry.parameter] != 0.0 ) {
+            std::cerr << "Error: B and gamma should be 0 in a SYMORO+ simple chain" << std::endl;
+            return false;
+        }
+    }
+    for(int e=0; e < (int)par_model.geometric_entries.size(); e++ ) {
+        const symoro_par_symbolic_entry & entry = par_model.geometric_entries[e];
+        par_model.geometricField(entry.field)[entry.link] = values[entry.parameter];
+    }
+
+    //Only the segments of the links that use a parameter are computed again
+    if( par_model.geometric_entries.empty() ) return true;
+    std::vector<bool> rebuilt_links(par_model.NL,false);
+    for(int e=0; e < (int)par_model.geometric_entries.size(); e++ ) {
+        rebuilt_links[par_model.geometric_entries[e].link] = true;
+    }
+    Tree new_tree;
+    if( !treeFromParModelTemplate(par_model,names,tree,rebuilt_links,std::vector<bool>(),new_tree) ) return false;
+    tree = new_tree;
+    return true;
+}
+
+bool geometricParameterFrameDerivatives(const symoro_par_model& par_model, const int parameter, std::vector<Twist>& derivatives,
+                                        const std::vector<double>& joint_positions)
+{
+    if( parameter < 0 || parameter >= (int)par_model.geometric_parameter_names.size() ) {
+        std::cerr << "Error: geometric parameter " << parameter << " not found" << std::endl;
+        return false;
+    }
+    if( !joint_positions.empty() && (int)joint_positions.size() != par_model.NL ) {
+        std::cerr << "Error: expected " << par_model.NL << " joint positions, got " << joint_positions.size() << std::endl;
+        return false;
+    }
+
+    //The entries are bare parameters, so the derivative of each frame is the sum of the
+    //derivatives with respect to the fields of the link that use the parameter
+    derivatives.assign(par_model.NL,Twist::Zero());
+    for(int e=0; e < (int)par_model.geometric_entries.size(); e++ ) {
+        const symoro_par_symbolic_entry & entry = par_model.geometric_entries[e];
+        if( entry.parameter != parameter ) continue;
+
+        int l = entry.link;
+        double q = joint_positions.empty() ? 0.0 : joint_positions[l];
+        double theta = par_model.Theta[l] + (par_model.Sigma[l] == 0 ? q : 0.0);
+        double r = par_model.R[l] + (par_model.Sigma[l] == 1 ? q : 0.0);
+        derivatives[l] += DH_Khalil1986_Tree_Derivative(par_model.d[l],par_model.Alpha[l],r,theta,
+                                                        par_model.gamma[l],par_model.B[l],entry.field);
+    }
+
+    return true;
+}
+
+bool bindInertialParameters(symoro_par_model& par_model, const std::vector<double>& values, Tree& tree)
+{
+    if( values.size() != par_model.inertial_parameter_names.size() ) {
+        std::cerr << "Error: expected " << par_model.inertial_parameter_names.size() << " inertial parameters, got " << values.size() << std::endl;
+        return false;
+    }
+
+    //Check the tree before modifying the model
+    symoro_par_names names;
+    if( !parTreeNames(par_model,tree,names) ) return false;
+
+    //Write the values in all the entries that use a symbolic parameter
+    for(int e=0; e < (int)par_model.inertial_entries.size(); e++ ) {
+        const symoro_par_symbolic_entry & entry = par_model.inertial_entries[e];
+        par_model.inertialField(entry.field)[entry.link] = values[entry.parameter];
+    }
+
+    //Only the inertia of the links that use a parameter is refreshed, the frames don't change
+    if( par_model.inertial_entries.empty() ) return true;
+    std::vector<bool> refreshed_inertia(par_model.NL,false);
+    for(int e=0; e < (int)par_model.inertial_entries.size(); e++ ) {
+        refreshed_inertia[par_model.inertial_entries[e].link] = true;
+    }
+    Tree new_tree;
+    if( !treeFromParModelTemplate(par_model,names,tree,std::vector<bool>(),refreshed_inertia,new_tree) ) return false;
+    tree = new_tree;
+    return true;
+}
+
 
 }
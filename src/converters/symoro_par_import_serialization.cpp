@@ -36,7 +36,7 @@
 
 #include "kdl_format_io/symoro_par_import_serialization.hpp"
 
-#include "../expression_parser/parser.h"
+#include "symoro_par_utils.hpp"
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -52,11 +52,10 @@ namespace kdl_format_io {
     
 bool treeSerializationFromSymoroParFile(const string& parfile_name, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
 {
-    ifstream ifs(parfile_name.c_str());
-    std::string xml_string( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
+    symoro_par_model par_model;
+    if( !parModelFromFile(parfile_name,par_model) ) return false;
 
-    return treeSerializationFromSymoroParString(xml_string,serialization,consider_first_link_inertia);
+    return treeSerializationFromParModel(par_model,serialization,consider_first_link_inertia);
 }
 
 bool treeSerializationFromSymoroParString(const string& parfile_name, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
@@ -68,98 +67,123 @@ bool treeSerializationFromSymoroParString(const string& parfile_name, KDL::CoDyC
 }
 
 
-std::string int2string_serialization(const int in)
+/**
+ * Build the serialization of a par model and, if tree is not NULL, its KDL::Tree
+ * in a single pass, sharing the names of links and joints
+ */
+bool treeAndSerializationFromParModelNames(const symoro_par_model& par_model, const symoro_par_names & names,
+                                           Tree * tree, KDL::CoDyCo::TreeSerialization& serialization)
 {
-    std::stringstream ss;
-    ss << in;
-    return ss.str();
-}
-
-
-
-
-bool treeSerializationFromParModelTree(const symoro_par_model& par_model, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
-{
-    /** \todo move this names in general header */
-    const std::string base_name = "Link0";
-    
-    //As the SYMORO .par doesn't support names for link and joints, the links will be named Link1, Link2, and joints Joint1, Joint2
-    const std::string link_common_name = "Link";
-    const std::string joint_common_name = "Joint";
-    
-    std::vector<std::string> link_names(par_model.NL+1);
-    std::vector<std::string> joint_names(par_model.NJ+1);
-    
-    //Return value
-    serialization.setNrOfLinks(par_model.NL+1);
-    serialization.setNrOfJunctions(par_model.NL);
-    serialization.setNrOfDOFs(par_model.NJ);
-    
-    int link_cnt = 0;
-    int dof_cnt = 0;
-    int fixed_junction_cnt = 0;
-        
-    /** \todo fix inconsistencies */
-    //serialization.links[link_cnt] = base_name;
-    serialization.setLinkNameID(base_name,link_cnt);
-    link_cnt++;
-    
+    //Moving joints are the first junctions (and have the same id as the corresponding DOF), followed by the fixed ones
+    int nr_of_dofs = 0;
     for(int l=0; l < par_model.NL; l++ ) {
-        std::string link_name = link_common_name + int2string_serialization(l+1);
-        std::string joint_name = joint_common_name + int2string_serialization(l+1);
-        //serialization.links[link_cnt] = link_name;
-        serialization.setLinkNameID(link_name,link_cnt);
-        link_cnt++;
-                                  
         switch( par_model.Sigma[l] ) {
             case 0:
             case 1:
-                //Moving joint
-                //serialization.dofs[dof_cnt] = joint_name;
-                //serialization.junctions[dof_cnt] = joint_name;
-                serialization.setDOFNameID(joint_name,dof_cnt);
-                serialization.setJunctionNameID(joint_name,dof_cnt);
-                dof_cnt++;
+                nr_of_dofs++;
             break;
-            case 2: 
-                //Fixed joint
-                //serialization.junctions[serialization.getNrOfDOFs()+fixed_junction_cnt] = joint_name;
-                serialization.setJunctionNameID(joint_name,serialization.getNrOfDOFs()+fixed_junction_cnt);
-                fixed_junction_cnt++;
+            case 2:
             break;
             default:
             std::cerr << "Error: Sigma value not expected"<< std::endl; return false;
             break;
         }
-        
-       
+    }
+
+    int nr_of_fake_links = names.has_fake_base ? 1 : 0;
+
+    //Return value
+    serialization.setNrOfLinks(par_model.NL+1+nr_of_fake_links);
+    serialization.setNrOfJunctions(par_model.NL+nr_of_fake_links);
+    serialization.setNrOfDOFs(nr_of_dofs);
+
+    int link_cnt = 0;
+    int dof_cnt = 0;
+    int fixed_junction_cnt = 0;
+
+    if( tree ) parCreateTreeRoot(names,*tree);
+
+    if( names.has_fake_base ) {
+        serialization.setLinkNameID(names.root_name,link_cnt);
+        link_cnt++;
+        serialization.setJunctionNameID(names.fake_base_joint_name,nr_of_dofs+fixed_junction_cnt);
+        fixed_junction_cnt++;
+    }
+
+    serialization.setLinkNameID(names.link_names[0],link_cnt);
+    link_cnt++;
+
+    for(int l=0; l < par_model.NL; l++ ) {
+        if( tree && !parAddLinkToTree(par_model,names,l,*tree) ) return false;
+
+        serialization.setLinkNameID(names.link_names[l+1],link_cnt);
+        link_cnt++;
+
+        if( par_model.Sigma[l] != 2 ) {
+            //Moving joint
+            serialization.setDOFNameID(names.joint_names[l],dof_cnt);
+            serialization.setJunctionNameID(names.joint_names[l],dof_cnt);
+            dof_cnt++;
+        } else {
+            //Fixed joint
+            serialization.setJunctionNameID(names.joint_names[l],nr_of_dofs+fixed_junction_cnt);
+            fixed_junction_cnt++;
+        }
     }
     return true;
-    
-}
 
-bool treeSerializationFromParModelChain(const symoro_par_model& par_model, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
-{
-    return false;   
 }
 
-bool treeSerializationFromParModel(const symoro_par_model& par_model, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
+/**
+ * Check that a par model can be converted to a tree
+ */
+bool checkParModelForTree(const symoro_par_model& par_model)
 {
-    if( par_model.Type != 1 && par_model.Type != 0 ) { 
+    if( par_model.Type != 1 && par_model.Type != 0 ) {
         std::cerr << "Error: currently are only supported SYMORO+ .par files of Type Tree (1) and Simple Chain (0)" << std::endl;
         return false;
     }
-    
+
     if( !par_model.isConsistent() ) {
         std::cerr << "Error: the SYMORO par model is not consistent" << std::endl;
         return false;
     }
-    
-    if( par_model.Type == 1 ) return treeSerializationFromParModelTree(par_model,serialization,consider_first_link_inertia);
-    if( par_model.Type == 0 ) return treeSerializationFromParModelChain(par_model,serialization,consider_first_link_inertia);
-   
-    std::cerr << "Error: currently are only supported SYMORO+ .par files of Type Tree (1) and Simple Chain (0)" << std::endl;
-    return false;
+
+    return true;
+}
+
+bool treeSerializationFromParModel(const symoro_par_model& par_model, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
+{
+    if( !checkParModelForTree(par_model) ) return false;
+
+    symoro_par_names names;
+    parModelNames(par_model,consider_first_link_inertia,names);
+    return treeAndSerializationFromParModelNames(par_model,names,0,serialization);
+}
+
+bool treeAndSerializationFromSymoroParFile(const string& parfile_name, Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
+{
+    symoro_par_model par_model;
+    if( !parModelFromFile(parfile_name,par_model) ) return false;
+
+    return treeAndSerializationFromParModel(par_model,tree,serialization,consider_first_link_inertia);
+}
+
+bool treeAndSerializationFromSymoroParString(const string& parfile_content, Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
+{
+    symoro_par_model par_model;
+    if( !parModelFromString(parfile_content,par_model) ) return false;
+
+    return treeAndSerializationFromParModel(par_model,tree,serialization,consider_first_link_inertia);
+}
+
+bool treeAndSerializationFromParModel(const symoro_par_model& par_model, Tree& tree, KDL::CoDyCo::TreeSerialization& serialization, const bool consider_first_link_inertia)
+{
+    if( !checkParModelForTree(par_model) ) return false;
+
+    symoro_par_names names;
+    parModelNames(par_model,consider_first_link_inertia,names);
+    return treeAndSerializationFromParModelNames(par_model,names,&tree,serialization);
 }
 
 
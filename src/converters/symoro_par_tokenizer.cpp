@@ -0,0 +1,227 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include "symoro_par_tokenizer.hpp"
+
+#include <iostream>
+
+namespace kdl_format_io {
+
+/**
+ * Check if c is a space that is not relevant to the contents of the file (space, tab, CR)
+ */
+static inline bool is_blank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_name_start(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool is_name_char(const char c)
+{
+    return is_name_start(c) || (c >= '0' && c <= '9');
+}
+
+static inline bool is_comment_start(const char * p, const char * end)
+{
+    return p+1 < end && p[0] == '(' && p[1] == '*';
+}
+
+/**
+ * Check if the character at p could be the start of a comment whose
+ * second character is not yet available
+ */
+static inline bool is_partial_comment_start(const char * p, const char * end, const bool last)
+{
+    return !last && p+1 == end && p[0] == '(';
+}
+
+static const char * skip_blanks(const char * p, const char * end)
+{
+    while( p < end && is_blank(*p) ) p++;
+    return p;
+}
+
+static par_text_range trimmed(const char * begin, const char * end)
+{
+    while( begin < end && (is_blank(*begin) || *begin == '\n') ) begin++;
+    while( end > begin && (is_blank(*(end-1)) || *(end-1) == '\n') ) end--;
+    return par_text_range(begin,end);
+}
+
+symoro_par_tokenizer::symoro_par_tokenizer(symoro_par_statement_handler & _handler):
+    handler(_handler), state(OUTSIDE)
+{
+}
+
+const char * symoro_par_tokenizer::stepOutside(const char * p, const char * end, const bool last, bool & error)
+{
+    if( is_blank(*p) || *p == '\n' ) return p+1;
+
+    if( is_partial_comment_start(p,end,last) ) return 0;
+    if( is_comment_start(p,end) ) { state = IN_COMMENT; return p+2; }
+
+    //Every definition starts with the name of the defined parameter
+    if( !is_name_start(*p) ) { state = SKIPPING_LINE; return p; }
+    const char * q = p;
+    while( q < end && is_name_char(*q) ) q++;
+    par_text_range name(p,q);
+
+    q = skip_blanks(q,end);
+    if( q == end ) return last ? end : 0;
+    if( *q != '=' ) { state = SKIPPING_LINE; return q; }
+    q = skip_blanks(q+1,end);
+    if( q == end && !last ) return 0;
+
+    if( q < end && *q == '{' ) {
+        //Vector definition, possibly spanning over several lines (and chunks)
+        bool skip = false;
+        vector_name = name.str();
+        if( !handler.vectorBegin(name,skip) ) { error = true; return 0; }
+        state = skip ? SKIPPING_VECTOR : IN_VECTOR;
+        return q+1;
+    }
+
+    //Scalar definition, ending at the end of the line or at the start of a comment
+    const char * value_begin = q;
+    while( q < end && *q != '\n' && !is_comment_start(q,end) ) q++;
+    if( q == end && !last ) return 0;
+    if( !handler.scalar(name,trimmed(value_begin,q)) ) { error = true; return 0; }
+    if( q == end || *q == '\n' ) state = SKIPPING_LINE;
+    return q;
+}
+
+const char * symoro_par_tokenizer::stepComment(const char * p, const char * end, const bool last)
+{
+    const char * q = p;
+    for(; q+1 < end; q++ ) {
+        if( q[0] == '*' && q[1] == ')' ) {
+            state = (state == IN_VECTOR_COMMENT) ? IN_VECTOR : OUTSIDE;
+            return q+2;
+        }
+    }
+    //The comment continues in the next chunk, keep only a possible '*' of the closing "*)"
+    if( !last && *q == '*' ) return q == p ? 0 : q;
+    return end;
+}
+
+const char * symoro_par_tokenizer::stepVector(const char * p, const char * end, const bool last, bool & error)
+{
+    if( is_blank(*p) || *p == '\n' ) return p+1;
+
+    if( is_partial_comment_start(p,end,last) ) return 0;
+    if( is_comment_start(p,end) ) { state = IN_VECTOR_COMMENT; return p+2; }
+
+    const char * q = p;
+    while( q < end && *q != ',' && *q != '}' ) q++;
+    if( q == end ) {
+        if( last ) { std::cerr << "Error: vector " << vector_name << " is not closed" << std::endl; error = true; }
+        return 0;
+    }
+
+    par_text_range elem = trimmed(p,q);
+    if( !elem.empty() && !handler.vectorElement(elem) ) { error = true; return 0; }
+
+    if( *q == '}' ) {
+        if( !handler.vectorEnd() ) { error = true; return 0; }
+        state = OUTSIDE;
+    }
+    return q+1;
+}
+
+const char * symoro_par_tokenizer::stepSkippingVector(const char * p, const char * end, bool & error)
+{
+    //The elements of a skipped vector are not needed, so they are consumed without waiting for them to be complete
+    const char * q = static_cast<const char *>(memchr(p,'}',end-p));
+    if( !q ) return end;
+    if( !handler.vectorEnd() ) { error = true; return 0; }
+    state = OUTSIDE;
+    return q+1;
+}
+
+bool symoro_par_tokenizer::feed(const char * begin, const char * end, const bool last, size_t & consumed)
+{
+    const char * p = begin;
+    bool error = false;
+
+    while( p < end ) {
+        const char * next = 0;
+        switch( state ) {
+            case OUTSIDE:
+                next = stepOutside(p,end,last,error);
+            break;
+            case SKIPPING_LINE:
+                next = static_cast<const char *>(memchr(p,'\n',end-p));
+                if( next ) { state = OUTSIDE; next++; } else { next = end; }
+            break;
+            case IN_COMMENT:
+            case IN_VECTOR_COMMENT:
+                next = stepComment(p,end,last);
+            break;
+            case IN_VECTOR:
+                next = stepVector(p,end,last,error);
+            break;
+            case SKIPPING_VECTOR:
+                next = stepSkippingVector(p,end,error);
+            break;
+        }
+        if( error ) return false;
+        //The item at p is not complete, it will be passed again with the next chunk
+        if( !next ) break;
+        p = next;
+    }
+
+    consumed = p-begin;
+
+    if( last && (state == IN_VECTOR || state == IN_VECTOR_COMMENT || state == SKIPPING_VECTOR) ) {
+        std::cerr << "Error: vector " << vector_name << " is not closed" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool tokenizeSymoroPar(const char * begin, const char * end, symoro_par_statement_handler & handler)
+{
+    symoro_par_tokenizer tokenizer(handler);
+    size_t consumed;
+    return tokenizer.feed(begin,end,true,consumed);
+}
+
+}
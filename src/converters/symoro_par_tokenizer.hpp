@@ -0,0 +1,155 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_TOKENIZER_H
+#define SYMORO_PAR_TOKENIZER_H
+
+#include <string>
+#include <cstring>
+
+namespace kdl_format_io {
+
+/**
+ * Read-only view on a range of characters of the content of a .par file
+ */
+struct par_text_range
+{
+    const char * begin;
+    const char * end;
+
+    par_text_range(): begin(0), end(0) {}
+    par_text_range(const char * _begin, const char * _end): begin(_begin), end(_end) {}
+
+    size_t size() const { return end-begin; }
+    bool empty() const { return begin == end; }
+
+    /**
+     * Check if the range is exactly equal to the null-terminated string str
+     */
+    bool equals(const char * str) const
+    {
+        size_t len = strlen(str);
+        return len == size() && strncmp(begin,str,len) == 0;
+    }
+
+    std::string str() const { return std::string(begin,end); }
+};
+
+/**
+ * Interface of the consumer of the statements found in a .par file.
+ *
+ * A .par file is a sequence of comments (* ... *), of scalar
+ * definitions (NL = 6) and of vector definitions (Ant = {0,1,1}) that
+ * can span multiple lines. Every method returns false to stop the
+ * tokenization, that will then fail.
+ */
+class symoro_par_statement_handler
+{
+public:
+    virtual ~symoro_par_statement_handler() {}
+
+    /**
+     * Called for each scalar definition, value is trimmed and stripped of comments
+     */
+    virtual bool scalar(const par_text_range & name, const par_text_range & value) = 0;
+
+    /**
+     * Called when a vector definition starts, set skip to true
+     * to avoid the vectorElement() calls for this vector
+     */
+    virtual bool vectorBegin(const par_text_range & name, bool & skip) = 0;
+
+    /**
+     * Called for each (trimmed, non empty) element of the vector
+     */
+    virtual bool vectorElement(const par_text_range & element) = 0;
+
+    /**
+     * Called after the last element of the vector
+     */
+    virtual bool vectorEnd() = 0;
+};
+
+/**
+ * Resumable tokenizer of the content of a .par file.
+ *
+ * The content can be passed in consecutive chunks with feed(): a definition
+ * (or a vector element) that is split between two chunks is left unconsumed,
+ * and it has to be passed again at the beginning of the next chunk. Memory
+ * needed by the caller is then bounded by the length of the longest scalar
+ * definition or vector element, independently of the size of the file.
+ */
+class symoro_par_tokenizer
+{
+public:
+    symoro_par_tokenizer(symoro_par_statement_handler & handler);
+
+    /**
+     * Tokenize the characters in [begin,end), without copying them.
+     * \param last true if the chunk is the last one of the file
+     * \param consumed number of characters consumed, the remaining ones
+     *                 must be passed again followed by the rest of the file
+     * returns true on success, false if the handler failed or a vector was not closed
+     */
+    bool feed(const char * begin, const char * end, const bool last, size_t & consumed);
+
+private:
+    enum tokenizer_state { OUTSIDE, SKIPPING_LINE, IN_COMMENT, IN_VECTOR, IN_VECTOR_COMMENT, SKIPPING_VECTOR };
+
+    symoro_par_statement_handler & handler;
+    tokenizer_state state;
+    std::string vector_name;
+
+    //Each step handles a single item at p, returning the first character after it
+    //(or NULL if the item is not complete in the chunk) and setting error on failure
+    const char * stepOutside(const char * p, const char * end, const bool last, bool & error);
+    const char * stepComment(const char * p, const char * end, const bool last);
+    const char * stepVector(const char * p, const char * end, const bool last, bool & error);
+    const char * stepSkippingVector(const char * p, const char * end, bool & error);
+};
+
+/**
+ * Tokenize the .par content in [begin,end) in a single pass, without copying it.
+ *
+ * The ranges passed to the handler point inside the original buffer.
+ * Lines that do not contain a definition are ignored.
+ * returns true on success, false if the handler failed or a vector was not closed
+ */
+bool tokenizeSymoroPar(const char * begin, const char * end, symoro_par_statement_handler & handler);
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2013, Istituto Italiano di Tecnologia
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#ifndef SYMORO_PAR_UTILS_H
+#define SYMORO_PAR_UTILS_H
+
+#include <string>
+#include <vector>
+
+#include "kdl_format_io/symoro_par_model.hpp"
+
+#include <kdl/tree.hpp>
+
+namespace kdl_format_io {
+
+/**
+ * Names of the links and joints of the KDL::Tree generated from a par model.
+ *
+ * As the SYMORO .par doesn't support names for link and joints, the links are
+ * named Link0 (the base), Link1, Link2, ... while the joints are named Joint1, Joint2, ...
+ * for trees and Joint0, Joint1, ... for chains.
+ */
+struct symoro_par_names
+{
+    std::string root_name;                  ///< name of the root of the KDL::Tree
+    bool has_fake_base;                     ///< true if root is a fake link attached with a fixed joint to Link0
+    std::string fake_base_joint_name;       ///< name of the fixed joint between the fake base and Link0
+    std::vector<std::string> link_names;    ///< link_names[0] is Link0, link_names[l+1] is the name of link l
+    std::vector<std::string> joint_names;   ///< joint_names[l] is the name of the joint of link l
+};
+
+/**
+ * Generate the names of the links and joints of the tree generated from a par model,
+ * following the conventions of treeFromParModel
+ */
+void parModelNames(const symoro_par_model& par_model, const bool consider_first_link_inertia, symoro_par_names & names);
+
+/**
+ * Convert the inertial parameters of link l to a KDL::RigidBodyInertia
+ */
+KDL::RigidBodyInertia parLinkInertia(const symoro_par_model & par_model, const int l);
+
+/**
+ * Build the segment of link l of a par model, to be attached to its parent link (par_model.Ant[l])
+ */
+bool parLinkSegment(const symoro_par_model& par_model, const int l,
+                    const std::string & link_name, const std::string & joint_name,
+                    const KDL::RigidBodyInertia & inertia, KDL::Segment & segment);
+
+/**
+ * Create the tree containing only the root of the tree generated from a par model
+ * (the base link, and the fake base if necessary)
+ */
+void parCreateTreeRoot(const symoro_par_names & names, KDL::Tree& tree);
+
+/**
+ * Add the segment of link l of a par model to a tree containing already its parent link
+ */
+bool parAddLinkToTree(const symoro_par_model& par_model, const symoro_par_names & names, const int l, KDL::Tree& tree);
+
+/**
+ * Build the tree of a chain (Type 0) or tree (Type 1) par model, given the names of links and joints
+ */
+bool treeFromParModelNames(const symoro_par_model& par_model, const symoro_par_names & names, KDL::Tree& tree);
+
+/**
+ * Build the tree of a par model reusing the segments of template_tree, a tree built from a model
+ * with the same structure and names. Only the segments of the links l with rebuilt_links[l] true
+ * are computed again from par_model (keeping the inertia of the template segment), while the
+ * links with refreshed_inertia[l] true get the inertia of par_model. An empty vector selects no link.
+ */
+bool treeFromParModelTemplate(const symoro_par_model& par_model, const symoro_par_names & names, const KDL::Tree & template_tree,
+                              const std::vector<bool> & rebuilt_links, const std::vector<bool> & refreshed_inertia, KDL::Tree& tree);
+
+/**
+ * Find the names used by treeFromParModel to build tree from par_model, so that the tree can be rebuilt
+ * with the same names (and the same fake base, if any) after the values of the parameters change.
+ * returns false if the tree was not built from a model with the structure of par_model
+ */
+bool parTreeNames(const symoro_par_model& par_model, const KDL::Tree& tree, symoro_par_names & names);
+
+/**
+ * Transform between the frames of two links, with the geometric parameters
+ * of Khalil 1986: Rot(z,gamma)*Trans(z,b)*Rot(x,alpha)*Trans(x,d)*Rot(z,theta)*Trans(z,r)
+ */
+KDL::Frame DH_Khalil1986_Tree(double d, double alpha, double r, double theta, double gamma, double b);
+
+/**
+ * Derivative of DH_Khalil1986_Tree with respect to the geometric parameter field
+ * (one of symoro_par_model::geometric_field), as the twist of the child frame:
+ * the velocity of its origin and its angular velocity, expressed in the parent
+ * frame, for a unit rate of the parameter
+ */
+KDL::Twist DH_Khalil1986_Tree_Derivative(double d, double alpha, double r, double theta, double gamma, double b, const int field);
+
+std::string int2string(const int in);
+
+}
+
+#endif
@@ -35,7 +35,13 @@
 /* Author: Silvio Traversaro */
 
 #include "kdl_format_io/urdf_sensor_import.hpp"
+#include "kdl_format_io/urdf_import.hpp"
+#include "numeric_scanner.hpp"
+#include <cctype>
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <map>
 #include <kdl/frames.hpp>
 #include <kdl/jntarray.hpp>
 #include <tinyxml.h>
@@ -55,120 +61,286 @@ bool ftSensorsFromUrdfFile(const std::string& file, std::vector<FTSensorData> &
     return ftSensorsFromUrdfString(xml_string,ft_sensors);
 }
 
-std::vector<std::string> &split(const std::string &s, std::vector<std::string> &elems) {
-    std::stringstream ss(s);
-    std::string item;
-    while (ss >> item) {
-        elems.push_back(item);
+/**
+ * Read a SDF pose "x y z roll pitch yaw" in place, without splitting the text
+ * returns false if the text does not contain exactly six numbers separated by blanks
+ */
+static bool scanPose(const char * text, KDL::Frame & pose)
+{
+    if( !text ) return false;
+    double elems[6];
+    const char * p = text;
+    for(int i=0; i < 6; i++ ) {
+        while( isspace((unsigned char)*p) ) p++;
+        const char * number_end = scanDouble(p,0,elems[i]);
+        if( number_end == p || (*number_end != '\0' && !isspace((unsigned char)*number_end)) ) return false;
+        p = number_end;
     }
-    return elems;
+    while( isspace((unsigned char)*p) ) p++;
+    if( *p != '\0' ) return false;
+
+    pose.M = KDL::Rotation::RPY(elems[3],elems[4],elems[5]);
+    pose.p = KDL::Vector(elems[0],elems[1],elems[2]);
+    return true;
 }
 
 
-bool ftSensorsFromUrdfString(const std::string& urdf_xml, std::vector<FTSensorData> & ft_sensors)
+void SensorTable::clear()
 {
-    ft_sensors.resize(0);
+    names.resize(0);
+    parent_names.resize(0);
+    parent_indices.resize(0);
+    poses.resize(0);
+}
 
-    /* parse sdf force_torque extension to urdf */
-    TiXmlDocument urdfXml;
-    urdfXml.Parse(urdf_xml.c_str());
+const char * SensorTables::sensorTypeName(const int type)
+{
+    switch( type ) {
+        case FORCE_TORQUE: return "force_torque";
+        case IMU: return "imu";
+        case ACCELEROMETER: return "accelerometer";
+        case GYROSCOPE: return "gyroscope";
+        default: return "";
+    }
+}
+
+bool SensorTables::isJointSensorType(const int type)
+{
+    return type == FORCE_TORQUE;
+}
+
+void SensorTables::clear()
+{
+    link_names.resize(0);
+    joint_names.resize(0);
+    for(int type=0; type < NR_OF_SENSOR_TYPES; type++ ) {
+        tables[type].clear();
+    }
+    ft_frames.resize(0);
+    ft_measure_directions.resize(0);
+}
+
+/**
+ * Read the frame and the measure direction of a force_torque sensor
+ */
+static bool readForceTorqueOptions(const TiXmlElement* sensorXml, int & frame, int & measure_direction)
+{
+    // Default value, check sdf documentation
+    frame = FTSensorData::CHILD_LINK_FRAME;
+    measure_direction = FTSensorData::CHILD_TO_PARENT;
+
+    const TiXmlElement* force_torque_tags = sensorXml->FirstChildElement("force_torque");
+    if( !force_torque_tags )
+    {
+        return true;
+    }
+
+    const TiXmlElement* frame_tag = sensorXml->FirstChildElement("frame");
+    if( frame_tag )
+    {
+        const char * frame_text = frame_tag->GetText();
+        if( frame_text == NULL )
+        {
+            return false;
+        }
+        else if( strcmp(frame_text,"child") == 0 )
+        {
+            frame = FTSensorData::CHILD_LINK_FRAME;
+        }
+        else if( strcmp(frame_text,"parent") == 0 )
+        {
+            frame = FTSensorData::PARENT_LINK_FRAME;
+        }
+        else if( strcmp(frame_text,"sensor") == 0 )
+        {
+            frame = FTSensorData::SENSOR_FRAME;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const TiXmlElement* measure_direction_tag = sensorXml->FirstChildElement("measure_direction");
+    if( measure_direction_tag )
+    {
+        const char * measure_direction_text = measure_direction_tag->GetText();
+        if( measure_direction_text == NULL )
+        {
+            return false;
+        }
+        else if( strcmp(measure_direction_text,"child_to_parent") == 0 )
+        {
+            measure_direction = FTSensorData::CHILD_TO_PARENT;
+        }
+        else if( strcmp(measure_direction_text,"parent_to_child") == 0 )
+        {
+            measure_direction = FTSensorData::PARENT_TO_CHILD;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Index of the sensor type with the given name, or -1 for an unsupported type
+ */
+static int sensorTypeFromName(const char * sensor_type)
+{
+    if( sensor_type == NULL ) return -1;
+    for(int type=0; type < SensorTables::NR_OF_SENSOR_TYPES; type++ ) {
+        if( strcmp(sensor_type,SensorTables::sensorTypeName(type)) == 0 ) return type;
+    }
+    return -1;
+}
+
+/**
+ * Read the sensors of the given type, or of all the supported types if type is -1.
+ * The sensors of the other types are skipped without checking them
+ */
+static bool sensorsOfTypeFromUrdfXml(const TiXmlDocument & urdf_xml, const int selected_type, SensorTables & sensors)
+{
+    sensors.clear();
 
-    TiXmlElement* robotXml = urdfXml.FirstChildElement("robot");
+    const TiXmlElement* robotXml = urdf_xml.FirstChildElement("robot");
+    if( !robotXml )
+    {
+        std::cerr << "[ERR] sensorsFromUrdfXml: robot tag not found" << std::endl;
+        return false;
+    }
 
-    // Get all SDF extension elements and search for the ft sensors
-    for (TiXmlElement* sdfXml = robotXml->FirstChildElement("gazebo");
-         sdfXml; sdfXml = sdfXml->NextSiblingElement("gazebo"))
+    // Single pass on the children of the robot: the links and the joints are
+    // collected together with the sensors of the SDF extension elements
+    for (const TiXmlElement* childXml = robotXml->FirstChildElement();
+         childXml; childXml = childXml->NextSiblingElement())
     {
-        const char* ref = sdfXml->Attribute("reference");
-        if (ref)
+        const char * child_tag = childXml->Value();
+
+        if( strcmp(child_tag,"link") == 0 || strcmp(child_tag,"joint") == 0 )
+        {
+            const char * name = childXml->Attribute("name");
+            std::vector<std::string> & names = child_tag[0] == 'l' ? sensors.link_names : sensors.joint_names;
+            names.push_back(name ? name : "");
+            continue;
+        }
+
+        if( strcmp(child_tag,"gazebo") != 0 ) continue;
+
+        const char* ref = childXml->Attribute("reference");
+        if( !ref ) continue;
+
+        for (const TiXmlElement* sensorXml = childXml->FirstChildElement("sensor");
+             sensorXml; sensorXml = sensorXml->NextSiblingElement("sensor"))
         {
-            for (TiXmlElement* sensorXml = sdfXml->FirstChildElement("sensor");
-                sensorXml; sensorXml = sensorXml->NextSiblingElement("sensor"))
+            int type = sensorTypeFromName(sensorXml->Attribute("type"));
+            if( type < 0 || (selected_type >= 0 && type != selected_type) ) continue;
+
+            const char * sensor_name = sensorXml->Attribute("name");
+            KDL::Frame sensor_pose = KDL::Frame::Identity();
+            const TiXmlElement* pose_tag = sensorXml->FirstChildElement("pose");
+            if( pose_tag && !scanPose(pose_tag->GetText(),sensor_pose) )
             {
-                  const char* sensor_type = sensorXml->Attribute("type");
-                  if( sensor_type != NULL && std::string(sensor_type) == "force_torque")
-                  {
-                      //Add the found ft sensor to the list
-                      FTSensorData new_ft;
-                      std::string refStr = std::string(ref);
-                      new_ft.reference_joint = refStr;
-                      new_ft.sensor_name = sensorXml->Attribute("name");
-                      // Default value, check sdf documentation
-                      new_ft.frame = kdl_format_io::FTSensorData::CHILD_LINK_FRAME;
-                      new_ft.measure_direction = kdl_format_io::FTSensorData::CHILD_TO_PARENT;
-                      new_ft.sensor_pose = KDL::Frame::Identity();
-                      TiXmlElement* force_torque_tags = sensorXml->FirstChildElement("force_torque");
-                      if( force_torque_tags )
-                      {
-                          TiXmlElement* frame_tag = sensorXml->FirstChildElement("frame");
-                          if( frame_tag )
-                          {
-                              std::string frame_text = frame_tag->GetText();
-                              if( frame_text == "child" )
-                              {
-                                  new_ft.frame = kdl_format_io::FTSensorData::CHILD_LINK_FRAME;
-                              }
-                              else if ( frame_text == "parent" )
-                              {
-                                  new_ft.frame = kdl_format_io::FTSensorData::PARENT_LINK_FRAME;
-                              }
-                              else if ( frame_text == "sensor" )
-                              {
-                                  new_ft.frame = kdl_format_io::FTSensorData::SENSOR_FRAME;
-                              }
-                              else
-                              {
-                                  return false;
-                              }
-
-                          }
-                          TiXmlElement* measure_direction_tag = sensorXml->FirstChildElement("measure_direction");
-                          if( measure_direction_tag )
-                          {
-                              std::string measure_direction_text = measure_direction_tag->GetText();
-                              if (measure_direction_text == "child_to_parent")
-                              {
-                                  new_ft.measure_direction = kdl_format_io::FTSensorData::CHILD_TO_PARENT;
-                              }
-                              else if (measure_direction_text == "parent_to_child" )
-                              {
-                                  new_ft.measure_direction = kdl_format_io::FTSensorData::PARENT_TO_CHILD;
-                              }
-                              else
-                              {
-                                  return false;
-                              }
-                          }
-                      }
-                      TiXmlElement* pose_tag = sensorXml->FirstChildElement("pose");
-                      if( pose_tag )
-                      {
-                          std::string  pose_text = pose_tag->GetText();
-                          std::vector<std::string> pose_elems;
-                          split(pose_text,pose_elems);
-                          if( pose_elems.size() != 6 )
-                          {
-                              return false;
-                          }
-                          double roll  = atof(pose_elems[3].c_str());
-                          double pitch = atof(pose_elems[4].c_str());
-                          double yaw   = atof(pose_elems[5].c_str());
-                          new_ft.sensor_pose.M = KDL::Rotation::RPY(roll,pitch,yaw);
-                          double x  = atof(pose_elems[0].c_str());
-                          double y = atof(pose_elems[1].c_str());
-                          double z   = atof(pose_elems[2].c_str());
-                          new_ft.sensor_pose.p = KDL::Vector(x,y,z);
-                      }
-
-                      ft_sensors.push_back(new_ft);
-
-                  }
+                std::cerr << "[ERR] sensorsFromUrdfXml: malformed pose of sensor " << (sensor_name ? sensor_name : "") << std::endl;
+                return false;
             }
+
+            if( type == SensorTables::FORCE_TORQUE )
+            {
+                int frame, measure_direction;
+                if( !readForceTorqueOptions(sensorXml,frame,measure_direction) ) return false;
+                sensors.ft_frames.push_back(frame);
+                sensors.ft_measure_directions.push_back(measure_direction);
+            }
+
+            SensorTable & table = sensors.tables[type];
+            table.names.push_back(sensor_name ? sensor_name : "");
+            table.parent_names.push_back(ref);
+            table.poses.push_back(sensor_pose);
+        }
+    }
+
+    // The references can precede the definition of their link or joint,
+    // so they are resolved once the whole document has been visited
+    std::map<std::string,int> link_indices, joint_indices;
+    for(int l=0; l < (int)sensors.link_names.size(); l++ ) link_indices.insert(std::make_pair(sensors.link_names[l],l));
+    for(int j=0; j < (int)sensors.joint_names.size(); j++ ) joint_indices.insert(std::make_pair(sensors.joint_names[j],j));
+
+    for(int type=0; type < SensorTables::NR_OF_SENSOR_TYPES; type++ ) {
+        SensorTable & table = sensors.tables[type];
+        const std::map<std::string,int> & indices = SensorTables::isJointSensorType(type) ? joint_indices : link_indices;
+        table.parent_indices.resize(table.size());
+        for(size_t s=0; s < table.size(); s++ ) {
+            std::map<std::string,int>::const_iterator it = indices.find(table.parent_names[s]);
+            table.parent_indices[s] = it == indices.end() ? -1 : it->second;
         }
     }
 
     return true;
 }
 
+bool sensorsFromUrdfXml(const TiXmlDocument & urdf_xml, SensorTables & sensors)
+{
+    return sensorsOfTypeFromUrdfXml(urdf_xml,-1,sensors);
+}
+
+bool sensorsFromUrdfString(const std::string& urdf_xml, SensorTables & sensors)
+{
+    TiXmlDocument urdfXml;
+    urdfXml.Parse(urdf_xml.c_str());
+    return sensorsFromUrdfXml(urdfXml,sensors);
+}
+
+bool sensorsFromUrdfFile(const std::string& file, SensorTables & sensors)
+{
+    ifstream ifs(file.c_str());
+    std::string xml_string( (std::istreambuf_iterator<char>(ifs) ),
+                       (std::istreambuf_iterator<char>()    ) );
+
+    return sensorsFromUrdfString(xml_string,sensors);
+}
+
+bool treeAndSensorsFromUrdfString(const std::string& urdf_xml, KDL::Tree& tree, SensorTables & sensors, const bool consider_root_link_inertia)
+{
+    return treeFromUrdfString(urdf_xml,tree,consider_root_link_inertia) && sensorsFromUrdfString(urdf_xml,sensors);
+}
+
+bool treeAndSensorsFromUrdfFile(const std::string& file, KDL::Tree& tree, SensorTables & sensors, const bool consider_root_link_inertia)
+{
+    ifstream ifs(file.c_str());
+    std::string xml_string( (std::istreambuf_iterator<char>(ifs) ),
+                       (std::istreambuf_iterator<char>()    ) );
+
+    return treeAndSensorsFromUrdfString(xml_string,tree,sensors,consider_root_link_inertia);
 }
 
+bool ftSensorsFromUrdfString(const std::string& urdf_xml, std::vector<FTSensorData> & ft_sensors)
+{
+    ft_sensors.resize(0);
+
+    //The other sensors are not read, so a malformed pose of an imu does not prevent
+    //the extraction of the force_torque sensors
+    TiXmlDocument urdfXml;
+    urdfXml.Parse(urdf_xml.c_str());
+    SensorTables sensors;
+    if( !sensorsOfTypeFromUrdfXml(urdfXml,SensorTables::FORCE_TORQUE,sensors) ) return false;
+
+    const SensorTable & ft_table = sensors.tables[SensorTables::FORCE_TORQUE];
+    ft_sensors.resize(ft_table.size());
+    for(size_t s=0; s < ft_table.size(); s++ ) {
+        FTSensorData & ft = ft_sensors[s];
+        ft.reference_joint = ft_table.parent_names[s];
+        ft.sensor_name = ft_table.names[s];
+        ft.frame = sensors.ft_frames[s] == FTSensorData::PARENT_LINK_FRAME ? FTSensorData::PARENT_LINK_FRAME :
+                   sensors.ft_frames[s] == FTSensorData::SENSOR_FRAME ? FTSensorData::SENSOR_FRAME : FTSensorData::CHILD_LINK_FRAME;
+        ft.measure_direction = sensors.ft_measure_directions[s] == FTSensorData::PARENT_TO_CHILD ?
+                               FTSensorData::PARENT_TO_CHILD : FTSensorData::CHILD_TO_PARENT;
+        ft.sensor_pose = ft_table.poses[s];
+    }
+
+    return true;
+}
+
+}
@@ -53,6 +53,17 @@ Error::Error(const int row, const int col, const int id, ...)
     va_end(args);
 }
 
+/**
+ * Store an error with given message id, filling in given string in message
+ */
+void ErrorStatus::set(const int err_row, const int err_col, const int err_id, const char arg[])
+{
+    row = err_row;
+    col = err_col;
+    id = err_id;
+    snprintf(msg, sizeof(msg), Error::msgdesc(err_id), arg);
+}
+
 /**
  * Returns a pointer to the message description for the given message id.
  * Returns "Unknown error" if id was not recognized.
@@ -69,18 +80,18 @@ const char* Error::msgdesc(const int id)
         case 5: return "Unexpected part \"%s\"";
         case 6: return "Unexpected end of expression";
         case 7: return "Value expected";
+        case 8: return "Brace { expected";
+        case 9: return "Brace } missing";
 
         // wrong or unknown operators, functions, variables
         case 101: return "Unknown operator %s";
         case 102: return "Unknown function %s";
         case 103: return "Unknown variable %s";
+        case 104: return "Unknown operator code %s";
 
         // domain errors
         case 200: return "Too long expression, maximum number of characters exceeded";
 
-        // error in assignments of variables
-        case 300: return "Defining variable failed";
-
         // error in functions
         case 400: return "Integer value expected in function %s";
     }
@@ -35,13 +35,33 @@ class Error {
         int get_id() {return err_id;}   // Returns the id of the error
         char* get_msg() {return msg;}   // Returns a pointer to the error msg
 
+        static const char* msgdesc(const int id);
+
     private:
         int err_row;    // row where the error occured
         int err_col;    // column (position) where the error occured
         int err_id;     // id of the error
         char msg[255];
+};
+
+
+/**
+ * Outcome of an evaluation: id is 0 on success, otherwise it is the
+ * id of the Error that occured, with its position and message
+ */
+struct ErrorStatus {
+    ErrorStatus() : id(0), row(-1), col(-1) {msg[0] = '\0';}
+
+    bool ok() const {return id == 0;}
+
+    // store the error with the given id, filling in arg in its message,
+    // without creating (and throwing) an Error
+    void set(const int err_row, const int err_col, const int err_id, const char arg[] = "");
 
-        const char* msgdesc(const int id);
+    int id;         // id of the error, 0 if no error occured
+    int row;        // row where the error occured
+    int col;        // column (position) where the error occured
+    char msg[255];  // error message, empty if no error occured
 };
 
 
@@ -25,19 +25,34 @@
 
 
 #include "error.h"
+#include "functions.h"
 
 /*
  * calculate factorial of value
  * for example 5! = 5*4*3*2*1 = 120
  */
 double factorial(double value)
+{
+    double res;
+    if (!factorial(value, res))
+    {
+        throw Error(-1, -1, 400, "factorial");
+    }
+    return res;
+}
+
+/*
+ * calculate factorial of value without throwing, returns false if
+ * value is not an integer
+ */
+bool factorial(double value, double & result)
 {
     double res;
     int v = static_cast<int>(value);
 
     if (value != static_cast<double>(v))
     {
-        throw Error(-1, -1, 400, "factorial");
+        return false;
     }
 
     res = v;
@@ -49,7 +64,8 @@ double factorial(double value)
     }
 
     if (res == 0) res = 1;        // 0! is per definition 1
-    return res;
+    result = res;
+    return true;
 }
 
 /*
@@ -31,6 +31,7 @@
 using namespace std;
 
 double factorial(double value);
+bool factorial(double value, double & result);
 double sign(double value);
 
 #endif
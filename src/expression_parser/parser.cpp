@@ -28,88 +28,479 @@
 
 // declarations
 #include "parser.h"
+#include "../converters/numeric_scanner.hpp"
 
 
 using namespace std;
 
 
 
+/*
+ * Compiler of a single expression in a Program, with recursive descent.
+ * All the state of a compilation is in the compiler, that lives on the
+ * stack of Parser::compile, so that compilations are reentrant
+ */
+class ExpressionCompiler
+{
+    public:
+        ExpressionCompiler(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status,
+                           ParserContext & context, const Variablelist & variables, Variablelist* new_variables,
+                           const bool append, const bool list);
+
+        bool compile();
+
+    // enumerations
+    private:
+
+        enum TOKENTYPE {NOTHING = -1, DELIMETER, NUMBER, VARIABLE, FUNCTION, UNKNOWN};
+
+        // the operators have the same id of the corresponding Program opcode
+        enum OPERATOR_ID {AND = Program::AND, OR, BITSHIFTLEFT, BITSHIFTRIGHT,  // level 2
+                       EQUAL, UNEQUAL, SMALLER, LARGER, SMALLEREQ, LARGEREQ,    // level 3
+                       PLUS, MINUS,                     // level 4
+                       MULTIPLY, DIVIDE, MODULUS, XOR,  // level 5
+                       POW,                             // level 6
+                       FACTORIAL = Program::FACTORIAL}; // level 7
+
+    // data
+    private:
+        // the expression is tokenized in place, in the buffer of the caller
+        const char* expr;             // points to the start of the expression
+        const char* expr_end;         // points after the last character of the expression
+        const char* e;                // points to a character in expr
+
+        const char* token;            // points to the start of the token in expr
+        int token_len;                // number of characters of the token
+        TOKENTYPE token_type;         // type of the token
+
+        Program & program;            // program being compiled
+        ErrorStatus & status;         // status of the compilation
+        ParserContext & context;      // working memory of the compilation
+
+        const Variablelist & variables;   // variables the program is bound to
+        Variablelist* new_variables;      // if not NULL, unknown variables are given a slot in it
+        bool append;                      // if true the expression is added as a new output of the program
+        bool list;                        // if true the expression is a list "{expr1, expr2, ...}" of outputs
+
+    // private functions
+    private:
+        bool getToken();
+        char at(const char* p) const {return p < expr_end ? *p : '\0';}
+        bool token_equals(const char str[]) const;
+        const char* token_str();
+
+        bool parse_list();
+        bool parse_level1();
+        bool parse_level2();
+        bool parse_level3();
+        bool parse_level4();
+        bool parse_level5();
+        bool parse_level6();
+        bool parse_level7();
+        bool parse_level8();
+        bool parse_level9();
+        bool parse_level10();
+        bool parse_number();
+
+        int get_operator_id() const;
+        void emit(const int op);
+        void emit_constant(const double value);
+        void emit_variable(const char var_name[]);
+
+        bool set_error(const int id, const char arg[] = "");
+
+        int row();
+        int col();
+};
+
+
 /*
  * constructor.
  * Initializes all data with zeros and empty strings
  */
 Parser::Parser(bool _consider_unknown_variables_as_zero): consider_unknown_variables_as_zero(_consider_unknown_variables_as_zero)
 {
-    expr[0] = '\0';
-    e = NULL;
-
-    token[0] = '\0';
-    token_type = NOTHING;
+    ans_str[0] = '\0';
 }
 
 
 /**
  * parses and evaluates the given expression
- * On error, an error of type Error is thrown
+ * returns a string "Ans = <result>" or "Error: <message>", on success the
+ * result is stored in the variable "Ans"
  */
 char* Parser::parse(const char new_expr[])
 {
-    try
+    ErrorStatus status;
+    double result = evaluate(new_expr, status);
+
+    if (status.ok())
     {
-        // check the length of expr
-        if ((int)strlen(new_expr) > EXPR_LEN_MAX)
+        // add the answer to memory as variable "Ans"
+        user_var.add("Ans", result);
+        //todo: restore snprintf
+        sprintf(ans_str, "Ans = %g", result);
+    }
+    else if (status.row == -1)
+    {
+        //todo: restore snprintf
+        sprintf(ans_str, "Error: %s (col %i)", status.msg, status.col);
+    }
+    else
+    {
+        //todo: restore snprintf
+        sprintf(ans_str, "Error: %s (ln %i, col %i)", status.msg, status.row, status.col);
+    }
+
+    return ans_str;
+}
+
+
+/**
+ * parses and evaluates the given expression, returning the result with full
+ * precision. On error, status describes the error and 0 is returned.
+ * An assignment "x = ..." stores the result in the variable x
+ */
+double Parser::evaluate(const char new_expr[], ErrorStatus & status)
+{
+    return evaluate(new_expr, new_expr + strlen(new_expr), status);
+}
+
+
+/**
+ * parses and evaluates the expression in the characters [expr_begin, expr_end),
+ * that do not need to be null-terminated
+ */
+double Parser::evaluate(const char* expr_begin, const char* expr_end, ErrorStatus & status)
+{
+    if (!compile(expr_begin, expr_end, context.scratch, status, context, &user_var, false, false))
+    {
+        return 0;
+    }
+
+    double ans = eval(context.scratch, status, context);
+    if (status.ok() && context.scratch.assigned_variable.size() > 0)
+    {
+        user_var.add(context.scratch.assigned_variable.c_str(), ans);
+    }
+
+    return ans;
+}
+
+
+/**
+ * parses and evaluates the expression in the characters [expr_begin, expr_end),
+ * without modifying the parser. The assignment "x = ..." is not performed
+ */
+double Parser::evaluate(const char* expr_begin, const char* expr_end, ErrorStatus & status, ParserContext & eval_context) const
+{
+    if (!compile(expr_begin, expr_end, eval_context.scratch, status, eval_context, NULL, false, false))
+    {
+        return 0;
+    }
+
+    return eval(eval_context.scratch, status, eval_context);
+}
+
+
+/**
+ * compiles the given expression in program, that can then be evaluated
+ * many times without parsing it again.
+ * returns true on success, on error status describes the error
+ */
+bool Parser::compile(const char new_expr[], Program & new_program, ErrorStatus & status)
+{
+    return compile(new_expr, new_expr + strlen(new_expr), new_program, status);
+}
+
+
+/**
+ * compiles the expression in the characters [expr_begin, expr_end). The
+ * expression is not copied and can have any length. The variables that are
+ * not yet defined are given a slot in user_var
+ */
+bool Parser::compile(const char* expr_begin, const char* expr_end, Program & new_program, ErrorStatus & status)
+{
+    return compile(expr_begin, expr_end, new_program, status, context, &user_var, false, false);
+}
+
+
+/**
+ * compiles the expression in the characters [expr_begin, expr_end) as a new
+ * output of the program, without removing the outputs already compiled.
+ * The variables that are not yet defined are given a slot in user_var.
+ * On error the program is left as it was before the call
+ */
+bool Parser::compile_output(const char* expr_begin, const char* expr_end, Program & new_program, ErrorStatus & status)
+{
+    return compile(expr_begin, expr_end, new_program, status, context, &user_var, true, false);
+}
+
+
+/**
+ * compiles the list of expressions "{expr1, expr2, ...}" in the characters
+ * [list_begin, list_end), with an output for each expression. The list can
+ * span many lines, and the variables that are not yet defined are given a
+ * slot in user_var
+ */
+bool Parser::compile_list(const char* list_begin, const char* list_end, Program & new_program, ErrorStatus & status)
+{
+    return compile(list_begin, list_end, new_program, status, context, &user_var, false, true);
+}
+
+
+/**
+ * parses and evaluates the list of expressions "{expr1, expr2, ...}" in the
+ * characters [list_begin, list_end), storing in results the value of each
+ * expression. On error, status describes the error and false is returned.
+ */
+bool Parser::evaluate_list(const char* list_begin, const char* list_end, vector<double> & results, ErrorStatus & status)
+{
+    results.resize(0);
+    if (!compile_list(list_begin, list_end, context.scratch, status))
+    {
+        return false;
+    }
+
+    results.resize(context.scratch.get_nr_of_outputs());
+    return results.empty() || eval(context.scratch, &results[0], status);
+}
+
+
+/**
+ * compiles the expression in the characters [expr_begin, expr_end) without
+ * modifying the parser
+ */
+bool Parser::compile(const char* expr_begin, const char* expr_end, Program & new_program, ErrorStatus & status, ParserContext & compile_context) const
+{
+    return compile(expr_begin, expr_end, new_program, status, compile_context, NULL, false, false);
+}
+
+
+/**
+ * compiles the expression in the characters [expr_begin, expr_end) as a new
+ * output of the program without modifying the parser
+ */
+bool Parser::compile_output(const char* expr_begin, const char* expr_end, Program & new_program, ErrorStatus & status, ParserContext & compile_context) const
+{
+    return compile(expr_begin, expr_end, new_program, status, compile_context, NULL, true, false);
+}
+
+
+/**
+ * compiles the list of expressions "{expr1, expr2, ...}" in the characters
+ * [list_begin, list_end) without modifying the parser
+ */
+bool Parser::compile_list(const char* list_begin, const char* list_end, Program & new_program, ErrorStatus & status, ParserContext & compile_context) const
+{
+    return compile(list_begin, list_end, new_program, status, compile_context, NULL, false, true);
+}
+
+
+/**
+ * compiles the expression, binding its variables to the slots of user_var.
+ * If new_variables is not NULL the variables that are not in user_var are
+ * added to it, otherwise they are looked up by name during the evaluation.
+ * If append is true the expression is added as a new output of the program,
+ * if list is true the expression is a list of expressions, one for each output
+ */
+bool Parser::compile(const char* expr_begin, const char* expr_end, Program & new_program, ErrorStatus & status,
+                     ParserContext & compile_context, Variablelist* new_variables, const bool append, const bool list) const
+{
+    ExpressionCompiler compiler(expr_begin, expr_end, new_program, status, compile_context, user_var, new_variables, append, list);
+    return compiler.compile();
+}
+
+
+/**
+ * evaluates a compiled program, taking the values of its variables from
+ * user_var (the assignment of the program, if any, is not performed).
+ * On error, status describes the error and 0 is returned.
+ */
+double Parser::eval(const Program & compiled, ErrorStatus & status)
+{
+    return eval(compiled, status, context);
+}
+
+
+/**
+ * evaluates all the outputs of a compiled program, storing their values in results.
+ * On error, status describes the error and false is returned.
+ */
+bool Parser::eval(const Program & compiled, double results[], ErrorStatus & status)
+{
+    return eval(compiled, results, status, context);
+}
+
+
+/**
+ * evaluates a compiled program without modifying the parser, so that many
+ * threads can evaluate programs at the same time, each with its own context
+ */
+double Parser::eval(const Program & compiled, ErrorStatus & status, ParserContext & eval_context) const
+{
+    if (!get_values(compiled, status, eval_context))
+    {
+        return 0;
+    }
+
+    vector<double> & values = eval_context.values;
+    return compiled.eval(values.empty() ? NULL : &values[0], status);
+}
+
+
+/**
+ * evaluates all the outputs of a compiled program without modifying the parser
+ */
+bool Parser::eval(const Program & compiled, double results[], ErrorStatus & status, ParserContext & eval_context) const
+{
+    if (!get_values(compiled, status, eval_context))
+    {
+        return false;
+    }
+
+    vector<double> & values = eval_context.values;
+    return compiled.eval(values.empty() ? NULL : &values[0], results, status);
+}
+
+
+/*
+ * stores in the context the values of the variables of a compiled program.
+ * On error, status describes the error and false is returned.
+ */
+bool Parser::get_values(const Program & compiled, ErrorStatus & status, ParserContext & eval_context) const
+{
+    status = ErrorStatus();
+
+    // a program compiled by this parser reads the values from the slots of
+    // user_var, otherwise the variables are looked up by name
+    bool bound = (compiled.variable_list_id == user_var.get_list_id());
+
+    vector<double> & values = eval_context.values;
+    values.resize(compiled.get_nr_of_variables());
+    for (int i = 0; i < compiled.get_nr_of_variables(); i++)
+    {
+        bool found = (bound && compiled.variable_ids[i] != -1)
+                     ? user_var.get_value(compiled.variable_ids[i], &values[i])
+                     : user_var.get_value(compiled.get_variable_name(i), &values[i]);
+        if (!found)
         {
-            throw Error(row(), col(), 200);
+            if (!consider_unknown_variables_as_zero)
+            {
+                status.set(-1, compiled.variable_cols[i], 103, compiled.get_variable_name(i));
+                return false;
+            }
+            values[i] = 0;
         }
+    }
+
+    return true;
+}
+
+
+/*
+ * constructor of the compiler of the expression in [expr_begin, expr_end)
+ */
+ExpressionCompiler::ExpressionCompiler(const char* expr_begin, const char* expr_end_, Program & new_program, ErrorStatus & compile_status,
+                                       ParserContext & compile_context, const Variablelist & bound_variables, Variablelist* new_variables_,
+                                       const bool append_, const bool list_)
+: expr(expr_begin), expr_end(expr_end_), e(expr_begin), token(expr_begin), token_len(0), token_type(NOTHING),
+  program(new_program), status(compile_status), context(compile_context),
+  variables(bound_variables), new_variables(new_variables_), append(append_), list(list_)
+{
+}
 
-        // initialize all variables
-        strncpy(expr, new_expr, EXPR_LEN_MAX - 1);  // copy the given expression to expr
-        e = expr;                                  // let e point to the start of the expression
-        ans = 0;
 
-        getToken();
-        if (token_type == DELIMETER && *token == '\0')
+/**
+ * compiles the expression in the program.
+ * returns true on success, on error status describes the error
+ */
+bool ExpressionCompiler::compile()
+{
+    status = ErrorStatus();
+    if (!append)
+    {
+        program.clear();
+    }
+    context.nodes.resize(0);
+
+    // the slots of the variables of a program compiled with another list
+    // refer to that list, so they are looked up again in this list
+    if (program.variable_list_id != variables.get_list_id())
+    {
+        for (unsigned int i = 0; i < program.variables.size(); i++)
         {
-            throw Error(row(), col(), 4);
+            const char* name = program.variables[i].c_str();
+            program.variable_ids[i] = new_variables ? new_variables->get_slot(name) : variables.find_slot(name);
         }
+        program.variable_list_id = variables.get_list_id();
+    }
 
-        ans = parse_level1();
-
-        // check for garbage at the end of the expression
-        // an expression ends with a character '\0' and token_type = delimeter
-        if (token_type != DELIMETER || *token != '\0')
+    // the variables of the outputs already compiled are shared
+    const int nr_of_nodes = program.nodes.size();
+    const int nr_of_variables = program.variables.size();
+    const int nr_of_outputs = program.outputs.size();
+    for (int i = 0; i < nr_of_variables; i++)
+    {
+        if (program.variable_ids[i] != -1)
         {
-            if (token_type == DELIMETER)
-            {
-                // user entered a not existing operator like "//"
-                throw Error(row(), col(), 101, token);
-            }
-            else
+            if (program.variable_ids[i] >= (int)context.program_slots.size())
             {
-                throw Error(row(), col(), 5, token);
+                context.program_slots.resize(variables.get_nr_of_slots(), -1);
             }
+            context.program_slots[program.variable_ids[i]] = i;
         }
+    }
 
-        // add the answer to memory as variable "Ans"
-        user_var.add("Ans", ans);
-        //todo: restore snprintf
-        sprintf(ans_str, "Ans = %g", ans);
+    // the errors are reported by set_error, and each function returns false
+    // as soon as an error occurs, so no exception is thrown
+    bool ok = getToken();
+    if (ok && token_type == DELIMETER && token_len == 0)
+    {
+        ok = set_error(4);
     }
-    catch (Error err)
+
+    if (list)
     {
-        if (err.get_row() == -1)
+        ok = ok && parse_list();
+    }
+    else
+    {
+        ok = ok && parse_level1();
+        if (ok) program.add_output(context.nodes.back());
+    }
+
+    // check for garbage at the end of the expression
+    // an expression ends with a character '\0' and token_type = delimeter
+    if (ok && (token_type != DELIMETER || token_len != 0))
+    {
+        if (token_type == DELIMETER)
         {
-		    //todo: restore snprintf
-            sprintf(ans_str, "Error: %s (col %i)", err.get_msg(), err.get_col());
+            // user entered a not existing operator like "//"
+            set_error(101, token_str());
         }
         else
         {
-		    //todo: restore snprintf
-            sprintf(ans_str, "Error: %s (ln %i, col %i)", err.get_msg(), err.get_row(), err.get_col());
+            set_error(5, token_str());
         }
     }
 
-    return ans_str;
+    // reset the program slots of the variables for the next compilation
+    for (unsigned int i = 0; i < program.variable_ids.size(); i++)
+    {
+        if (program.variable_ids[i] != -1)
+        {
+            context.program_slots[program.variable_ids[i]] = -1;
+        }
+    }
+    if (!status.ok())
+    {
+        program.rollback(nr_of_nodes, nr_of_variables, nr_of_outputs);
+        return false;
+    }
+
+    program.schedule();
+    return true;
 }
 
 
@@ -183,128 +574,107 @@ bool isDigit(const char c)
 
 /**
  * Get next token in the current string expr.
- * Uses the Parser data expr, e, token, t, token_type and err
+ * Uses the Parser data expr, e, token, token_len and token_type. The token
+ * is not copied, it points to its characters in expr.
+ * Returns false if the token is not valid
  */
-void Parser::getToken()
+bool ExpressionCompiler::getToken()
 {
     token_type = NOTHING;
-    char* t;           // points to a character in token
-    t = token;         // let t point to the first character in token
-    *t = '\0';         // set token empty
-
-    //printf("\tgetToken e:{%c}, ascii=%i, col=%i\n", *e, *e, e-expr);
 
-    // skip over whitespaces
-    while (*e == ' ' || *e == '\t')     // space or tab
+    // skip over whitespaces, a list can also span many lines
+    while (at(e) == ' ' || at(e) == '\t' || (list && (at(e) == '\n' || at(e) == '\r')))
     {
         e++;
     }
 
+    token = e;         // the token starts at the current character
+    token_len = 0;     // set token empty
+
     // check for end of expression
-    if (*e == '\0')
+    if (at(e) == '\0')
     {
         // token is still empty
         token_type = DELIMETER;
-        return;
+        return true;
     }
 
     // check for minus
     if (*e == '-')
     {
         token_type = DELIMETER;
-        *t = *e;
         e++;
-        t++;
-        *t = '\0';  // add a null character at the end of token
-        return;
     }
 
     // check for parentheses
-    if (*e == '(' || *e == ')')
+    else if (*e == '(' || *e == ')')
+    {
+        token_type = DELIMETER;
+        e++;
+    }
+
+    // check for the braces and the separators of a list
+    else if (list && (*e == '{' || *e == '}' || *e == ','))
     {
         token_type = DELIMETER;
-        *t = *e;
         e++;
-        t++;
-        *t = '\0';
-        return;
     }
 
     // check for operators (delimeters)
-    if (isDelimeter(*e))
+    else if (isDelimeter(*e))
     {
         token_type = DELIMETER;
-        while (isDelimeter(*e))
+        while (isDelimeter(at(e)))
         {
-            *t = *e;
             e++;
-            t++;
         }
-        *t = '\0';  // add a null character at the end of token
-        return;
     }
 
     // check for a value
-    if (isDigitDot(*e))
+    else if (isDigitDot(*e))
     {
         token_type = NUMBER;
-        while (isDigitDot(*e))
+        while (isDigitDot(at(e)))
         {
-            *t = *e;
             e++;
-            t++;
         }
 
         // check for scientific notation like "2.3e-4" or "1.23e50"
-        if (toupper(*e) == 'E')
+        if (toupper(at(e)) == 'E')
         {
-            *t = *e;
             e++;
-            t++;
 
-            if (*e == '+' || *e == '-')
+            if (at(e) == '+' || at(e) == '-')
             {
-                *t = *e;
                 e++;
-                t++;
             }
 
-            while (isDigit(*e))
+            while (isDigit(at(e)))
             {
-                *t = *e;
                 e++;
-                t++;
             }
         }
-
-        *t = '\0';
-        return;
     }
 
     // check for variables or functions
-    if (isAlpha(*e))
+    else if (isAlpha(*e))
     {
-        while (isAlpha(*e) || isDigit(*e))
-        //while (isNotDelimeter(*e))
+        while (isAlpha(at(e)) || isDigit(at(e)))
         {
-            *t = *e;
             e++;
-            t++;
         }
-        *t = '\0';  // add a null character at the end of token
 
         // check if this is a variable or a function.
         // a function has a parentesis '(' open after the name
-        char* e2 = NULL;
-        e2 = e;
+        const char* e2 = e;
 
         // skip whitespaces
-        while (*e2 == ' ' || *e2 == '\t')     // space or tab
+        while (at(e2) == ' ' || at(e2) == '\t')     // space or tab
         {
             e2++;
         }
 
-        if (*e2 == '(')
+        if (at(e2) == '(')
         {
             token_type = FUNCTION;
         }
@@ -312,56 +682,106 @@ void Parser::getToken()
         {
             token_type = VARIABLE;
         }
-        return;
     }
 
-    // something unknown is found, wrong characters -> a syntax error
-    token_type = UNKNOWN;
-    while (*e != '\0')
+    else
     {
-        *t = *e;
-        e++;
-        t++;
+        // something unknown is found, wrong characters -> a syntax error
+        token_type = UNKNOWN;
+        e = expr_end;
+        token_len = e - token;
+        return set_error(1, token_str());
+    }
+
+    token_len = e - token;
+    return true;
+}
+
+
+/*
+ * returns true if the current token is equal to the null-terminated string str
+ */
+bool ExpressionCompiler::token_equals(const char str[]) const
+{
+    return strncmp(token, str, token_len) == 0 && str[token_len] == '\0';
+}
+
+
+/*
+ * returns a null-terminated copy of the current token, stored in the arena
+ * of the parser. The copy is valid until the next call
+ */
+const char* ExpressionCompiler::token_str()
+{
+    context.arena.assign(token, token + token_len);
+    context.arena.push_back('\0');
+    return &context.arena[0];
+}
+
+
+/*
+ * list of expressions "{expr1, expr2, ...}", each expression is an output
+ * of the program. Assignments are not allowed in a list, so "x = 1" is a comparison
+ */
+bool ExpressionCompiler::parse_list()
+{
+    if (!token_equals("{")) return set_error(8);
+    if (!getToken()) return false;
+
+    if (token_equals("}"))
+    {
+        return getToken();
     }
-    *t = '\0';
-    throw Error(row(), col(), 1, token);
 
-    return;
+    while (true)
+    {
+        if (!parse_level2()) return false;
+        program.add_output(context.nodes.back());
+        context.nodes.pop_back();
+
+        if (token_equals("}"))
+        {
+            return getToken();
+        }
+        if (!token_equals(","))
+        {
+            if (token_type == DELIMETER && token_len == 0) return set_error(9);
+            return set_error(5, token_str());
+        }
+        if (!getToken()) return false;
+    }
 }
 
 
 /*
  * assignment of variable or function
  */
-double Parser::parse_level1()
+bool ExpressionCompiler::parse_level1()
 {
     if (token_type == VARIABLE)
     {
-        // copy current token
-        char* e_now = e;
+        // remember current token, it is a view on expr so nothing is copied
+        const char* e_now = e;
         TOKENTYPE token_type_now = token_type;
-        char token_now[NAME_LEN_MAX+1];
-        strcpy(token_now, token);
+        const char* token_now = token;
+        int token_len_now = token_len;
 
-        getToken();
-        if (strcmp(token, "=") == 0)
+        if (!getToken()) return false;
+        if (token_equals("="))
         {
-            // assignment
-            double ans;
-            getToken();
-            ans = parse_level2();
-            if (user_var.add(token_now, ans) == false)
-            {
-                throw Error(row(), col(), 300);
-            }
-            return ans;
+            // assignment, performed after the evaluation
+            if (!getToken()) return false;
+            if (!parse_level2()) return false;
+            program.assigned_variable.assign(token_now, token_len_now);
+            return true;
         }
         else
         {
             // go back to previous token
             e = e_now;
             token_type = token_type_now;
-            strcpy(token, token_now);
+            token = token_now;
+            token_len = token_len_now;
         }
     }
 
@@ -372,191 +792,177 @@ double Parser::parse_level1()
 /*
  * conditional operators and bitshift
  */
-double Parser::parse_level2()
+bool ExpressionCompiler::parse_level2()
 {
     int op_id;
-    double ans;
-    ans = parse_level3();
+    if (!parse_level3()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == AND || op_id == OR || op_id == BITSHIFTLEFT || op_id == BITSHIFTRIGHT)
     {
-        getToken();
-        ans = eval_operator(op_id, ans, parse_level3());
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        if (!parse_level3()) return false;
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 /*
  * conditional operators
  */
-double Parser::parse_level3()
+bool ExpressionCompiler::parse_level3()
 {
     int op_id;
-    double ans;
-    ans = parse_level4();
+    if (!parse_level4()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == EQUAL || op_id == UNEQUAL || op_id == SMALLER || op_id == LARGER || op_id == SMALLEREQ || op_id == LARGEREQ)
     {
-        getToken();
-        ans = eval_operator(op_id, ans, parse_level4());
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        if (!parse_level4()) return false;
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 /*
  * add or subtract
  */
-double Parser::parse_level4()
+bool ExpressionCompiler::parse_level4()
 {
     int op_id;
-    double ans;
-    ans = parse_level5();
+    if (!parse_level5()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == PLUS || op_id == MINUS)
     {
-        getToken();
-        ans = eval_operator(op_id, ans, parse_level5());
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        if (!parse_level5()) return false;
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 
 /*
  * multiply, divide, modulus, xor
  */
-double Parser::parse_level5()
+bool ExpressionCompiler::parse_level5()
 {
     int op_id;
-    double ans;
-    ans = parse_level6();
+    if (!parse_level6()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == MULTIPLY || op_id == DIVIDE || op_id == MODULUS || op_id == XOR)
     {
-        getToken();
-        ans = eval_operator(op_id, ans, parse_level6());
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        if (!parse_level6()) return false;
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 
 /*
  * power
  */
-double Parser::parse_level6()
+bool ExpressionCompiler::parse_level6()
 {
     int op_id;
-    double ans;
-    ans = parse_level7();
+    if (!parse_level7()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == POW)
     {
-        getToken();
-        ans = eval_operator(op_id, ans, parse_level7());
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        if (!parse_level7()) return false;
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 /*
  * Factorial
  */
-double Parser::parse_level7()
+bool ExpressionCompiler::parse_level7()
 {
     int op_id;
-    double ans;
-    ans = parse_level8();
+    if (!parse_level8()) return false;
 
-    op_id = get_operator_id(token);
+    op_id = get_operator_id();
     while (op_id == FACTORIAL)
     {
-        getToken();
-        // factorial does not need a value right from the
-        // operator, so zero is filled in.
-        ans = eval_operator(op_id, ans, 0.0);
-        op_id = get_operator_id(token);
+        if (!getToken()) return false;
+        // factorial does not need a value right from the operator
+        emit(op_id);
+        op_id = get_operator_id();
     }
-
-    return ans;
+    return true;
 }
 
 /*
  * Unary minus
  */
-double Parser::parse_level8()
+bool ExpressionCompiler::parse_level8()
 {
-    double ans;
-
-    int op_id = get_operator_id(token);
+    int op_id = get_operator_id();
     if (op_id == MINUS)
     {
-        getToken();
-        ans = parse_level9();
-        ans = -ans;
-    }
-    else
-    {
-        ans = parse_level9();
+        if (!getToken()) return false;
+        if (!parse_level9()) return false;
+        emit(Program::NEGATE);
+        return true;
     }
 
-    return ans;
+    return parse_level9();
 }
 
 
 /*
  * functions
  */
-double Parser::parse_level9()
+bool ExpressionCompiler::parse_level9()
 {
-    char fn_name[NAME_LEN_MAX+1];
-    double ans;
-
     if (token_type == FUNCTION)
     {
-        strcpy(fn_name, token);
-        getToken();
-        ans = eval_function(fn_name, parse_level10());
-    }
-    else
-    {
-        ans = parse_level10();
+        // the function is resolved at compile time
+        int fn_op = Program::get_function_opcode(token_str());
+        if (fn_op == -1)
+        {
+            return set_error(102, token_str());
+        }
+        if (!getToken()) return false;
+        if (!parse_level10()) return false;
+        emit(fn_op);
+        return true;
     }
 
-    return ans;
+    return parse_level10();
 }
 
 
 /*
  * parenthesized expression or value
  */
-double Parser::parse_level10()
+bool ExpressionCompiler::parse_level10()
 {
     // check if it is a parenthesized expression
     if (token_type == DELIMETER)
     {
-        if (token[0] == '(' && token[1] == '\0')
+        if (token_equals("("))
         {
-            getToken();
-            double ans = parse_level2();
-            if (token_type != DELIMETER || token[0] != ')' || token[1] || '\0')
+            if (!getToken()) return false;
+            if (!parse_level2()) return false;
+            if (token_type != DELIMETER || !token_equals(")"))
             {
-                throw Error(row(), col(), 3);
+                return set_error(3);
             }
-            getToken();
-            return ans;
+            return getToken();
         }
     }
 
@@ -565,201 +971,170 @@ double Parser::parse_level10()
 }
 
 
-double Parser::parse_number()
+bool ExpressionCompiler::parse_number()
 {
-double ans = 0;
-
     switch (token_type)
     {
         case NUMBER:
-            // this is a number
-            ans = strtod(token, NULL);
-            getToken();
-            break;
+            // this is a number, read without copying the token and
+            // independently of the decimal separator of the locale
+            {
+                double value;
+                kdl_format_io::scanDouble(token, token + token_len, value);
+                emit_constant(value);
+            }
+            return getToken();
 
         case VARIABLE:
             // this is a variable
-            ans = eval_variable(token);
-            getToken();
-            break;
+            emit_variable(token_str());
+            return getToken();
 
         default:
             // syntax error or unexpected end of expression
-            if (token[0] == '\0')
+            if (token_len == 0)
             {
-                throw Error(row(), col(), 6);
+                return set_error(6);
             }
             else
             {
-                throw Error(row(), col(), 7);
+                return set_error(7);
             }
-            break;
     }
-
-    return ans;
 }
 
 
 /*
- * returns the id of the given operator
+ * returns the id of the operator in the current token
  * treturns -1 if the operator is not recognized
  */
-int Parser::get_operator_id(const char op_name[])
+int ExpressionCompiler::get_operator_id() const
 {
     // level 2
-    if (!strcmp(op_name, "&")) {return AND;}
-    if (!strcmp(op_name, "|")) {return OR;}
-    if (!strcmp(op_name, "<<")) {return BITSHIFTLEFT;}
-    if (!strcmp(op_name, ">>")) {return BITSHIFTRIGHT;}
+    if (token_equals("&")) {return AND;}
+    if (token_equals("|")) {return OR;}
+    if (token_equals("<<")) {return BITSHIFTLEFT;}
+    if (token_equals(">>")) {return BITSHIFTRIGHT;}
 
     // level 3
-    if (!strcmp(op_name, "=")) {return EQUAL;}
-    if (!strcmp(op_name, "<>")) {return UNEQUAL;}
-    if (!strcmp(op_name, "<")) {return SMALLER;}
-    if (!strcmp(op_name, ">")) {return LARGER;}
-    if (!strcmp(op_name, "<=")) {return SMALLEREQ;}
-    if (!strcmp(op_name, ">=")) {return LARGEREQ;}
+    if (token_equals("=")) {return EQUAL;}
+    if (token_equals("<>")) {return UNEQUAL;}
+    if (token_equals("<")) {return SMALLER;}
+    if (token_equals(">")) {return LARGER;}
+    if (token_equals("<=")) {return SMALLEREQ;}
+    if (token_equals(">=")) {return LARGEREQ;}
 
     // level 4
-    if (!strcmp(op_name, "+")) {return PLUS;}
-    if (!strcmp(op_name, "-")) {return MINUS;}
+    if (token_equals("+")) {return PLUS;}
+    if (token_equals("-")) {return MINUS;}
 
     // level 5
-    if (!strcmp(op_name, "*")) {return MULTIPLY;}
-    if (!strcmp(op_name, "/")) {return DIVIDE;}
-    if (!strcmp(op_name, "%")) {return MODULUS;}
-    if (!strcmp(op_name, "||")) {return XOR;}
+    if (token_equals("*")) {return MULTIPLY;}
+    if (token_equals("/")) {return DIVIDE;}
+    if (token_equals("%")) {return MODULUS;}
+    if (token_equals("||")) {return XOR;}
 
     // level 6
-    if (!strcmp(op_name, "^")) {return POW;}
+    if (token_equals("^")) {return POW;}
 
     // level 7
-    if (!strcmp(op_name, "!")) {return FACTORIAL;}
+    if (token_equals("!")) {return FACTORIAL;}
 
     return -1;
 }
 
 
 /*
- * evaluate an operator for given valuess
+ * add to the program the operation op on the operands at the top of the node
+ * stack, replacing them with the node of the result
  */
-double Parser::eval_operator(const int op_id, const double &lhs, const double &rhs)
+void ExpressionCompiler::emit(const int op)
 {
-    switch (op_id)
+    vector<int> & nodes = context.nodes;
+    int node;
+    if (Program::is_binary(op))
     {
-        // level 2
-        case AND:           return static_cast<int>(lhs) & static_cast<int>(rhs);
-        case OR:            return static_cast<int>(lhs) | static_cast<int>(rhs);
-        case BITSHIFTLEFT:  return static_cast<int>(lhs) << static_cast<int>(rhs);
-        case BITSHIFTRIGHT: return static_cast<int>(lhs) >> static_cast<int>(rhs);
-
-        // level 3
-        case EQUAL:     return lhs == rhs;
-        case UNEQUAL:   return lhs != rhs;
-        case SMALLER:   return lhs < rhs;
-        case LARGER:    return lhs > rhs;
-        case SMALLEREQ: return lhs <= rhs;
-        case LARGEREQ:  return lhs >= rhs;
-
-        // level 4
-        case PLUS:      return lhs + rhs;
-        case MINUS:     return lhs - rhs;
-
-        // level 5
-        case MULTIPLY:  return lhs * rhs;
-        case DIVIDE:    return lhs / rhs;
-        case MODULUS:   return static_cast<int>(lhs) % static_cast<int>(rhs); // todo: give a warning if the values are not integer?
-        case XOR:       return static_cast<int>(lhs) ^ static_cast<int>(rhs);
-
-        // level 6
-        case POW:       return pow(lhs, rhs);
-
-        // level 7
-        case FACTORIAL: return factorial(lhs);
+        node = program.add_operation(op, nodes[nodes.size() - 2], nodes.back());
+        nodes.pop_back();
     }
-
-    throw Error(row(), col(), 104, op_id);
-    return 0;
+    else
+    {
+        node = program.add_operation(op, nodes.back());
+    }
+    nodes.back() = node;
 }
 
 
 /*
- * evaluate a function
+ * push the node of a constant value
  */
-double Parser::eval_function(const char fn_name[], const double &value)
+void ExpressionCompiler::emit_constant(const double value)
 {
-    try
-    {
-        // first make the function name upper case
-        char fnU[NAME_LEN_MAX+1];
-        toupper(fnU, fn_name);
+    context.nodes.push_back(program.add_constant(value));
+}
+
 
-        // arithmetic
-        if (!strcmp(fnU, "ABS")) {return abs(value);}
-        if (!strcmp(fnU, "EXP")) {return exp(value);}
-        if (!strcmp(fnU, "SIGN")) {return sign(value);}
-        if (!strcmp(fnU, "SQRT")) {return sqrt(value);}
-        if (!strcmp(fnU, "LOG")) {return log(value);}
-        if (!strcmp(fnU, "LOG10")) {return log10(value);}
+/*
+ * push the node of a variable. The built-in variables are
+ * constants, the other ones are given a slot of the program
+ */
+void ExpressionCompiler::emit_variable(const char var_name[])
+{
+    // check for built-in variables
+    if (Variablelist::equals_no_case(var_name, "E")) {emit_constant(2.7182818284590452353602874713527); return;}
+    if (Variablelist::equals_no_case(var_name, "PI")) {emit_constant(3.1415926535897932384626433832795); return;}
 
-        // trigonometric
-        if (!strcmp(fnU, "SIN")) {return sin(value);}
-        if (!strcmp(fnU, "COS")) {return cos(value);}
-        if (!strcmp(fnU, "TAN")) {return tan(value);}
-        if (!strcmp(fnU, "ASIN")) {return asin(value);}
-        if (!strcmp(fnU, "ACOS")) {return acos(value);}
-        if (!strcmp(fnU, "ATAN")) {return atan(value);}
+    // the slot in the variable list identifies the variable, also if it has no value yet
+    int id = new_variables ? new_variables->get_slot(var_name) : variables.find_slot(var_name);
 
-        // probability
-        if (!strcmp(fnU, "FACTORIAL")) {return factorial(value);}
+    int slot;
+    if (id != -1)
+    {
+        if (id >= (int)context.program_slots.size())
+        {
+            context.program_slots.resize(variables.get_nr_of_slots(), -1);
+        }
+        slot = context.program_slots[id];
     }
-    catch (Error err)
+    else
     {
-        // retrow error, add information about column and row of occurance
-        // TODO: doesnt work yet
-        throw Error(col(), row(), err.get_id(), err.get_msg());
+        // the variable is not in the list, it will be looked up by name
+        slot = program.get_variable_slot(var_name);
     }
 
-    // unknown function
-    throw Error(row(), col(), 102, fn_name);
-    return 0;
+    if (slot == -1)
+    {
+        slot = program.variables.size();
+        program.variables.push_back(var_name);
+        program.variable_cols.push_back(col());
+        program.variable_ids.push_back(id);
+        if (id != -1)
+        {
+            context.program_slots[id] = slot;
+        }
+    }
+    context.nodes.push_back(program.add_variable(slot));
 }
 
 
+
 /*
- * evaluate a variable
+ * stores the error with the given id (and argument of its message) at the
+ * position of the current token in the status of the compilation.
+ * Always returns false, so it can be used as "return set_error(...)"
  */
-double Parser::eval_variable(const char var_name[])
+bool ExpressionCompiler::set_error(const int id, const char arg[])
 {
-    // first make the variable name uppercase
-    char varU[NAME_LEN_MAX+1];
-    toupper(varU, var_name);
-
-    // check for built-in variables
-    if (!strcmp(varU, "E")) {return 2.7182818284590452353602874713527;}
-    if (!strcmp(varU, "PI")) {return 3.1415926535897932384626433832795;}
-
-    // check for user defined variables
-    double ans;
-    if (user_var.get_value(var_name, &ans))
-    {
-        return ans;
-    }
-
-    // unknown variable
-    if( !consider_unknown_variables_as_zero ) {
-        throw Error(row(), col(), 103, var_name);
-    } 
-    return 0;
+    status.set(row(), col(), id, arg);
+    return false;
 }
 
 
-
 /*
  * Shortcut for getting the current row value (one based)
  * Returns the line of the currently handled expression
  */
-int Parser::row()
+int ExpressionCompiler::row()
 {
     return -1;
 }
@@ -768,7 +1143,7 @@ int Parser::row()
  * Shortcut for getting the current col value (one based)
  * Returns the column (position) where the last token starts
  */
-int Parser::col()
+int ExpressionCompiler::col()
 {
-    return e-expr-strlen(token)+1;
+    return token-expr+1;
 }
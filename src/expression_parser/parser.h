@@ -25,6 +25,8 @@
  *     Other:
  *        Scientific notation supported
  *         Error handling supported
+ *         Expressions can be compiled once in a Program, and evaluated
+ *         many times without parsing them again
  *
  * @license
  * Licensed under the Apache License, Version 2.0 (the "License"); you may not
@@ -64,69 +66,81 @@
 #include "error.h"
 #include "functions.h"
 #include "variablelist.h"
+#include "program.h"
 
 using namespace std;
 
+/*
+ * Working memory used to compile and evaluate expressions. A context can be
+ * used by only one thread at a time, and it can be reused across calls to
+ * avoid allocations
+ */
+class ParserContext
+{
+    private:
+        friend class Parser;
+        friend class ExpressionCompiler;
+
+        vector<char> arena;           // storage of the null-terminated copies of the tokens
+        vector<int> program_slots;    // slot in the compiled program of each slot of the variable list, -1 if not used
+        vector<int> nodes;            // nodes of the program holding the operands during the compilation
+        vector<double> values;        // values of the variables of the evaluated program
+        Program scratch;              // program used by evaluate
+};
+
+
 class Parser
 {
     // public functions
     public:
         Parser(bool _consider_unknown_variables_as_zero=false);
         char* parse(const char expr[]);
-        
-        Variablelist user_var;        // list with variables defined by user
-
+        double evaluate(const char expr[], ErrorStatus & status);
+        double evaluate(const char* expr_begin, const char* expr_end, ErrorStatus & status);
+
+        bool compile(const char expr[], Program & program, ErrorStatus & status);
+        bool compile(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status);
+        double eval(const Program & program, ErrorStatus & status);
+        bool eval(const Program & program, double results[], ErrorStatus & status);
+
+        // compiles the expression as a new output of the program, sharing
+        // its constants, variables and subexpressions with the other outputs
+        bool compile_output(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status);
+
+        // compiles a list of expressions "{expr1, expr2, ...}" in a program with an output
+        // for each expression, that share their variables and subexpressions
+        bool compile_list(const char* list_begin, const char* list_end, Program & program, ErrorStatus & status);
+
+        // parses and evaluates a list of expressions, storing their values in results
+        bool evaluate_list(const char* list_begin, const char* list_end, vector<double> & results, ErrorStatus & status);
+
+        // reentrant versions, that modify neither the parser nor user_var: they can be
+        // called concurrently by many threads, each one with its own context.
+        // An assignment "x = ..." is not performed by evaluate
+        double evaluate(const char* expr_begin, const char* expr_end, ErrorStatus & status, ParserContext & context) const;
+        bool compile(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status, ParserContext & context) const;
+        double eval(const Program & program, ErrorStatus & status, ParserContext & context) const;
+        bool eval(const Program & program, double results[], ErrorStatus & status, ParserContext & context) const;
+        bool compile_output(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status, ParserContext & context) const;
+        bool compile_list(const char* list_begin, const char* list_end, Program & program, ErrorStatus & status, ParserContext & context) const;
 
-    // enumerations
-    private:
-
-        enum TOKENTYPE {NOTHING = -1, DELIMETER, NUMBER, VARIABLE, FUNCTION, UNKNOWN};
+        Variablelist user_var;        // list with variables defined by user
 
-        enum OPERATOR_ID {AND, OR, BITSHIFTLEFT, BITSHIFTRIGHT,                 // level 2
-                       EQUAL, UNEQUAL, SMALLER, LARGER, SMALLEREQ, LARGEREQ,    // level 3
-                       PLUS, MINUS,                     // level 4
-                       MULTIPLY, DIVIDE, MODULUS, XOR,  // level 5
-                       POW,                             // level 6
-                       FACTORIAL};                      // level 7
 
     // data
     private:
-        char expr[EXPR_LEN_MAX+1];    // holds the expression
-        char* e;                      // points to a character in expr
-
-        char token[NAME_LEN_MAX+1];   // holds the token
-        TOKENTYPE token_type;         // type of the token
-
-        double ans;                   // holds the result of the expression
         char ans_str[255];            // holds a string containing the result
                                       // of the expression
-                                      
-        bool consider_unknown_variables_as_zero; //if true consider unknown variables as zero instead of givin error
 
+        ParserContext context;        // context of the non reentrant functions
+
+        bool consider_unknown_variables_as_zero; //if true consider unknown variables as zero instead of givin error
 
     // private functions
     private:
-        void getToken();
-
-        double parse_level1();
-        double parse_level2();
-        double parse_level3();
-        double parse_level4();
-        double parse_level5();
-        double parse_level6();
-        double parse_level7();
-        double parse_level8();
-        double parse_level9();
-        double parse_level10();
-        double parse_number();
-
-        int get_operator_id(const char op_name[]);
-        double eval_operator(const int op_id, const double &lhs, const double &rhs);
-        double eval_function(const char fn_name[], const double &value);
-        double eval_variable(const char var_name[]);
-
-        int row();
-        int col();
+        bool compile(const char* expr_begin, const char* expr_end, Program & program, ErrorStatus & status,
+                     ParserContext & context, Variablelist* new_variables, const bool append, const bool list) const;
+        bool get_values(const Program & program, ErrorStatus & status, ParserContext & context) const;
 };
 
 #endif
@@ -0,0 +1,729 @@
+/**
+ * @file program.cpp
+ *
+ * @brief
+ * Compiled expression. See the header file for more detailed explanation
+ *
+ * @license
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy
+ * of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+// declarations
+#include "program.h"
+#include "functions.h"
+#include "variablelist.h"
+
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#include <Eigen/Core>
+
+
+using namespace std;
+
+
+/*
+ * case insensitive comparison of two null-terminated strings
+ */
+static bool equalsNoCase(const char* a, const char* b)
+{
+    while (*a != '\0' && std::toupper((unsigned char)*a) == std::toupper((unsigned char)*b))
+    {
+        a++;
+        b++;
+    }
+    return std::toupper((unsigned char)*a) == std::toupper((unsigned char)*b);
+}
+
+
+Program::Program()
+{
+    clear();
+}
+
+/*
+ * remove all the instructions, constants, outputs and variables
+ */
+void Program::clear()
+{
+    nodes.resize(0);
+    constants.resize(0);
+    constant_nodes.clear();
+    variable_nodes.clear();
+    operation_nodes.clear();
+    outputs.resize(0);
+    code.resize(0);
+    output_registers.resize(0);
+    nr_of_registers = 0;
+    variables.resize(0);
+    variable_cols.resize(0);
+    variable_list_id = 0;
+    variable_ids.resize(0);
+    assigned_variable.clear();
+}
+
+bool Program::NodeKey::operator<(const NodeKey & other) const
+{
+    if (op != other.op) return op < other.op;
+    if (lhs != other.lhs) return lhs < other.lhs;
+    return rhs < other.rhs;
+}
+
+/*
+ * returns the node of the given constant, adding it if not yet present
+ */
+int Program::add_constant(const double value)
+{
+    map<double, int>::iterator it = constant_nodes.find(value);
+    if (it != constant_nodes.end())
+    {
+        return it->second;
+    }
+
+    Instruction node = {LOAD_CONSTANT, (int)constants.size(), -1, -1, -1};
+    constants.push_back(value);
+    nodes.push_back(node);
+    constant_nodes[value] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+/*
+ * returns the node of the variable in the given slot, adding it if not yet present
+ */
+int Program::add_variable(const int slot)
+{
+    map<int, int>::iterator it = variable_nodes.find(slot);
+    if (it != variable_nodes.end())
+    {
+        return it->second;
+    }
+
+    Instruction node = {LOAD_VARIABLE, slot, -1, -1, -1};
+    nodes.push_back(node);
+    variable_nodes[slot] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+/*
+ * returns the node of the given operation on the nodes lhs and rhs (-1 for
+ * unary operators and functions). If all the operands are constants the
+ * operation is folded in a constant, and an operation equal to an existing
+ * one is not added again
+ */
+int Program::add_operation(const int op, const int lhs, const int rhs)
+{
+    if (nodes[lhs].op == LOAD_CONSTANT && (rhs == -1 || nodes[rhs].op == LOAD_CONSTANT))
+    {
+        // the operations that fail (or give nan) are kept, so that the error
+        // is reported during the evaluation as for the other expressions
+        ErrorStatus status;
+        double value = apply(op, constants[nodes[lhs].arg], rhs == -1 ? 0.0 : constants[nodes[rhs].arg], status);
+        if (status.ok() && value == value)
+        {
+            return add_constant(value);
+        }
+    }
+
+    NodeKey key = {op, lhs, rhs};
+    if (is_commutative(op) && rhs < lhs)
+    {
+        key.lhs = rhs;
+        key.rhs = lhs;
+    }
+
+    map<NodeKey, int>::iterator it = operation_nodes.find(key);
+    if (it != operation_nodes.end())
+    {
+        return it->second;
+    }
+
+    Instruction node = {op, 0, key.lhs, key.rhs, -1};
+    nodes.push_back(node);
+    operation_nodes[key] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+/*
+ * add the given node as the last output of the program
+ */
+void Program::add_output(const int node)
+{
+    outputs.push_back(node);
+}
+
+/*
+ * remove the nodes, variables and outputs added after the program had the
+ * given number of them (for example by an expression that failed to compile)
+ */
+void Program::rollback(const int nr_of_nodes, const int nr_of_variables, const int nr_of_outputs)
+{
+    outputs.resize(nr_of_outputs);
+
+    if ((int)nodes.size() > nr_of_nodes)
+    {
+        nodes.resize(nr_of_nodes);
+
+        // rebuild the tables of the nodes, some of them are now removed
+        int nr_of_constants = 0;
+        constant_nodes.clear();
+        variable_nodes.clear();
+        operation_nodes.clear();
+        for (int i = 0; i < nr_of_nodes; i++)
+        {
+            const Instruction & node = nodes[i];
+            if (node.op == LOAD_CONSTANT)
+            {
+                constant_nodes[constants[node.arg]] = i;
+                nr_of_constants = node.arg + 1;
+            }
+            else if (node.op == LOAD_VARIABLE)
+            {
+                variable_nodes[node.arg] = i;
+            }
+            else
+            {
+                NodeKey key = {node.op, node.lhs, node.rhs};
+                operation_nodes[key] = i;
+            }
+        }
+        constants.resize(nr_of_constants);
+    }
+
+    variables.resize(nr_of_variables);
+    variable_cols.resize(nr_of_variables);
+    variable_ids.resize(nr_of_variables);
+}
+
+/*
+ * marks the nodes needed to compute the outputs: a node is needed if it is
+ * an output or an operand of a needed node
+ */
+void Program::get_needed_nodes(vector<bool> & needed) const
+{
+    needed.assign(nodes.size(), false);
+    for (unsigned int o = 0; o < outputs.size(); o++)
+    {
+        needed[outputs[o]] = true;
+    }
+    for (int i = nodes.size() - 1; i >= 0; i--)
+    {
+        if (needed[i] && nodes[i].lhs != -1) needed[nodes[i].lhs] = true;
+        if (needed[i] && nodes[i].rhs != -1) needed[nodes[i].rhs] = true;
+    }
+}
+
+
+/*
+ * build the instructions that compute the outputs: only the nodes needed by
+ * the outputs are computed, in the order in which they were added, and the
+ * registers of the values that are no more needed are reused
+ */
+void Program::schedule()
+{
+    const int nr_of_nodes = nodes.size();
+    vector<bool> needed;
+    get_needed_nodes(needed);
+
+    // last node using each node, the outputs are used until the end
+    vector<int> last_use(nr_of_nodes, -1);
+    for (int i = 0; i < nr_of_nodes; i++)
+    {
+        if (!needed[i]) continue;
+        if (nodes[i].lhs != -1) last_use[nodes[i].lhs] = i;
+        if (nodes[i].rhs != -1) last_use[nodes[i].rhs] = i;
+    }
+    for (unsigned int o = 0; o < outputs.size(); o++)
+    {
+        last_use[outputs[o]] = nr_of_nodes;
+    }
+
+    code.resize(0);
+    nr_of_registers = 0;
+    vector<int> registers(nr_of_nodes, -1);
+    vector<int> free_registers;
+    for (int i = 0; i < nr_of_nodes; i++)
+    {
+        if (!needed[i]) continue;
+
+        Instruction ins = nodes[i];
+        if (ins.lhs != -1)
+        {
+            ins.lhs = registers[nodes[i].lhs];
+            if (last_use[nodes[i].lhs] == i) free_registers.push_back(ins.lhs);
+        }
+        if (ins.rhs != -1)
+        {
+            ins.rhs = registers[nodes[i].rhs];
+            if (last_use[nodes[i].rhs] == i && nodes[i].rhs != nodes[i].lhs) free_registers.push_back(ins.rhs);
+        }
+
+        // the result can be stored in the register of an operand, as
+        // the operands are read before the result is written
+        if (free_registers.empty())
+        {
+            ins.dest = nr_of_registers++;
+        }
+        else
+        {
+            ins.dest = free_registers.back();
+            free_registers.pop_back();
+        }
+        registers[i] = ins.dest;
+        code.push_back(ins);
+    }
+
+    output_registers.resize(outputs.size());
+    for (unsigned int o = 0; o < outputs.size(); o++)
+    {
+        output_registers[o] = registers[outputs[o]];
+    }
+}
+
+/*
+ * returns the slot of the given variable, -1 if the program does not use it.
+ * Name is case insensitive
+ */
+int Program::get_variable_slot(const char* name) const
+{
+    for (unsigned int i = 0; i < variables.size(); i++)
+    {
+        if (equalsNoCase(variables[i].c_str(), name))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * returns the opcode of the function with the given (case insensitive)
+ * name, -1 if the function is not known
+ */
+int Program::get_function_opcode(const char fn_name[])
+{
+    // arithmetic
+    if (equalsNoCase(fn_name, "ABS")) {return ABS;}
+    if (equalsNoCase(fn_name, "EXP")) {return EXP;}
+    if (equalsNoCase(fn_name, "SIGN")) {return SIGN;}
+    if (equalsNoCase(fn_name, "SQRT")) {return SQRT;}
+    if (equalsNoCase(fn_name, "LOG")) {return LOG;}
+    if (equalsNoCase(fn_name, "LOG10")) {return LOG10;}
+
+    // trigonometric
+    if (equalsNoCase(fn_name, "SIN")) {return SIN;}
+    if (equalsNoCase(fn_name, "COS")) {return COS;}
+    if (equalsNoCase(fn_name, "TAN")) {return TAN;}
+    if (equalsNoCase(fn_name, "ASIN")) {return ASIN;}
+    if (equalsNoCase(fn_name, "ACOS")) {return ACOS;}
+    if (equalsNoCase(fn_name, "ATAN")) {return ATAN;}
+
+    // probability
+    if (equalsNoCase(fn_name, "FACTORIAL")) {return FACTORIAL;}
+
+    return -1;
+}
+
+/*
+ * returns the node of the given operation, as add_operation. The operations
+ * whose result is known from an operand equal to 0 or 1 (as x*0, x*1, x+0)
+ * are not added, so the derivatives do not contain the terms that vanish
+ */
+int Program::add_derivative_operation(const int op, const int lhs, const int rhs)
+{
+    const int zero = add_constant(0.0);
+    const int one = add_constant(1.0);
+
+    switch (op)
+    {
+        case PLUS:
+            if (lhs == zero) return rhs;
+            if (rhs == zero) return lhs;
+            break;
+        case MINUS:
+            if (rhs == zero) return lhs;
+            if (lhs == zero) return add_derivative_operation(NEGATE, rhs);
+            break;
+        case MULTIPLY:
+            if (lhs == zero || rhs == zero) return zero;
+            if (lhs == one) return rhs;
+            if (rhs == one) return lhs;
+            break;
+        case DIVIDE:
+            if (lhs == zero) return zero;
+            if (rhs == one) return lhs;
+            break;
+        case NEGATE:
+            if (nodes[lhs].op == NEGATE) return nodes[lhs].lhs;
+            break;
+    }
+    return add_operation(op, lhs, rhs);
+}
+
+
+/*
+ * builds the derivatives of the outputs with respect to the variable slot,
+ * applying the chain rule to each node needed by the outputs (forward mode).
+ * The derivatives are nodes of the same graph, so they share the
+ * subexpressions of the program, and they are folded and shared as the
+ * nodes added by the compiler. The operators whose value is piecewise
+ * constant (comparisons, integer operators, sign and factorial) have a zero
+ * derivative where it is defined.
+ */
+void Program::differentiate(const int slot, Program & derivative) const
+{
+    Program result(*this);
+    result.outputs.resize(0);
+
+    vector<bool> needed;
+    get_needed_nodes(needed);
+
+    const int zero = result.add_constant(0.0);
+    const int one = result.add_constant(1.0);
+
+    // d[i] is the node of the derivative of the node i
+    vector<int> d(nodes.size(), zero);
+    for (unsigned int i = 0; i < nodes.size(); i++)
+    {
+        if (!needed[i]) continue;
+
+        const int a = nodes[i].lhs;
+        const int b = nodes[i].rhs;
+        const int da = (a != -1) ? d[a] : zero;
+        const int db = (b != -1) ? d[b] : zero;
+        int tmp;
+
+        switch (nodes[i].op)
+        {
+            case LOAD_VARIABLE:
+                d[i] = (nodes[i].arg == slot) ? one : zero;
+                break;
+
+            case PLUS:
+            case MINUS:
+                d[i] = result.add_derivative_operation(nodes[i].op, da, db);
+                break;
+
+            case MULTIPLY:
+                d[i] = result.add_derivative_operation(PLUS, result.add_derivative_operation(MULTIPLY, da, b),
+                                                             result.add_derivative_operation(MULTIPLY, a, db));
+                break;
+
+            case DIVIDE:
+                // (a/b)' = a'/b - (a/b)*b'/b
+                tmp = result.add_derivative_operation(DIVIDE, result.add_derivative_operation(MULTIPLY, i, db), b);
+                d[i] = result.add_derivative_operation(MINUS, result.add_derivative_operation(DIVIDE, da, b), tmp);
+                break;
+
+            case POW:
+                if (db == zero)
+                {
+                    // (a^b)' = b*a^(b-1)*a'
+                    tmp = result.add_operation(POW, a, result.add_operation(MINUS, b, one));
+                    d[i] = result.add_derivative_operation(MULTIPLY, result.add_derivative_operation(MULTIPLY, b, tmp), da);
+                }
+                else
+                {
+                    // (a^b)' = a^b*(b'*log(a) + b*a'/a)
+                    tmp = result.add_derivative_operation(DIVIDE, result.add_derivative_operation(MULTIPLY, b, da), a);
+                    tmp = result.add_derivative_operation(PLUS, result.add_derivative_operation(MULTIPLY, db, result.add_operation(LOG, a)), tmp);
+                    d[i] = result.add_derivative_operation(MULTIPLY, i, tmp);
+                }
+                break;
+
+            case NEGATE:
+                d[i] = result.add_derivative_operation(NEGATE, da);
+                break;
+
+            case ABS:
+                d[i] = result.add_derivative_operation(MULTIPLY, result.add_operation(SIGN, a), da);
+                break;
+
+            case EXP:
+                d[i] = result.add_derivative_operation(MULTIPLY, i, da);
+                break;
+
+            case SQRT:
+                // sqrt(a)' = a'/(2*sqrt(a))
+                tmp = result.add_operation(MULTIPLY, result.add_constant(2.0), i);
+                d[i] = result.add_derivative_operation(DIVIDE, da, tmp);
+                break;
+
+            case LOG:
+                d[i] = result.add_derivative_operation(DIVIDE, da, a);
+                break;
+
+            case LOG10:
+                tmp = result.add_operation(MULTIPLY, a, result.add_constant(log(10.0)));
+                d[i] = result.add_derivative_operation(DIVIDE, da, tmp);
+                break;
+
+            case SIN:
+                d[i] = result.add_derivative_operation(MULTIPLY, result.add_operation(COS, a), da);
+                break;
+
+            case COS:
+                tmp = result.add_derivative_operation(MULTIPLY, result.add_operation(SIN, a), da);
+                d[i] = result.add_derivative_operation(NEGATE, tmp);
+                break;
+
+            case TAN:
+                // tan(a)' = (1 + tan(a)^2)*a'
+                tmp = result.add_operation(PLUS, one, result.add_operation(MULTIPLY, i, i));
+                d[i] = result.add_derivative_operation(MULTIPLY, tmp, da);
+                break;
+
+            case ASIN:
+            case ACOS:
+                // asin(a)' = a'/sqrt(1 - a^2) = -acos(a)'
+                tmp = result.add_operation(SQRT, result.add_operation(MINUS, one, result.add_operation(MULTIPLY, a, a)));
+                d[i] = result.add_derivative_operation(DIVIDE, da, tmp);
+                if (nodes[i].op == ACOS) d[i] = result.add_derivative_operation(NEGATE, d[i]);
+                break;
+
+            case ATAN:
+                tmp = result.add_operation(PLUS, one, result.add_operation(MULTIPLY, a, a));
+                d[i] = result.add_derivative_operation(DIVIDE, da, tmp);
+                break;
+
+            default:
+                // constants and piecewise constant operators
+                d[i] = zero;
+                break;
+        }
+    }
+
+    for (unsigned int o = 0; o < outputs.size(); o++)
+    {
+        result.add_output(d[outputs[o]]);
+    }
+    result.schedule();
+    derivative = result;
+}
+
+
+/*
+ * returns true if the result of the binary operator op does not depend
+ * on the order of its operands
+ */
+bool Program::is_commutative(const int op)
+{
+    return op == AND || op == OR || op == EQUAL || op == UNEQUAL ||
+           op == PLUS || op == MULTIPLY || op == XOR;
+}
+
+/*
+ * evaluate an operator or a function for the given values
+ * (rhs is not used for unary operators and functions).
+ * On error, status describes the error and 0 is returned
+ */
+double Program::apply(const int op, const double lhs, const double rhs, ErrorStatus & status)
+{
+    double result;
+
+    switch (op)
+    {
+        // level 2
+        case AND:           return static_cast<int>(lhs) & static_cast<int>(rhs);
+        case OR:            return static_cast<int>(lhs) | static_cast<int>(rhs);
+        case BITSHIFTLEFT:  return static_cast<int>(lhs) << static_cast<int>(rhs);
+        case BITSHIFTRIGHT: return static_cast<int>(lhs) >> static_cast<int>(rhs);
+
+        // level 3
+        case EQUAL:     return lhs == rhs;
+        case UNEQUAL:   return lhs != rhs;
+        case SMALLER:   return lhs < rhs;
+        case LARGER:    return lhs > rhs;
+        case SMALLEREQ: return lhs <= rhs;
+        case LARGEREQ:  return lhs >= rhs;
+
+        // level 4
+        case PLUS:      return lhs + rhs;
+        case MINUS:     return lhs - rhs;
+
+        // level 5
+        case MULTIPLY:  return lhs * rhs;
+        case DIVIDE:    return lhs / rhs;
+        case MODULUS:   return static_cast<int>(lhs) % static_cast<int>(rhs); // todo: give a warning if the values are not integer?
+        case XOR:       return static_cast<int>(lhs) ^ static_cast<int>(rhs);
+
+        // level 6
+        case POW:       return pow(lhs, rhs);
+
+        // unary operators
+        case NEGATE:    return -lhs;
+        case FACTORIAL:
+            if (!factorial(lhs, result))
+            {
+                status.set(-1, -1, 400, "factorial");
+                return 0;
+            }
+            return result;
+
+        // functions
+        case ABS:   return fabs(lhs);
+        case EXP:   return exp(lhs);
+        case SIGN:  return sign(lhs);
+        case SQRT:  return sqrt(lhs);
+        case LOG:   return log(lhs);
+        case LOG10: return log10(lhs);
+        case SIN:   return sin(lhs);
+        case COS:   return cos(lhs);
+        case TAN:   return tan(lhs);
+        case ASIN:  return asin(lhs);
+        case ACOS:  return acos(lhs);
+        case ATAN:  return atan(lhs);
+    }
+
+    status.set(-1, -1, 104);
+    return 0;
+}
+
+/*
+ * evaluate the program, values contains the values of the variable slots.
+ * Returns the value of the last output, on error status describes the
+ * error and 0 is returned.
+ */
+double Program::eval(const double values[], ErrorStatus & status) const
+{
+    // the registers are allocated on the heap only for very large programs
+    double small_results[32];
+    vector<double> large_results;
+    double* results = small_results;
+    if (outputs.size() > 32)
+    {
+        large_results.resize(outputs.size());
+        results = &large_results[0];
+    }
+
+    if (!eval(values, results, status) || outputs.empty())
+    {
+        return 0;
+    }
+    return results[outputs.size() - 1];
+}
+
+/*
+ * evaluate the program, storing in results the values of all the outputs.
+ * On error, status describes the error and false is returned.
+ */
+bool Program::eval(const double values[], double results[], ErrorStatus & status) const
+{
+    status = ErrorStatus();
+
+    // the registers are allocated on the heap only for very large programs
+    double small_regs[32];
+    vector<double> large_regs;
+    double* regs = small_regs;
+    if (nr_of_registers > 32)
+    {
+        large_regs.resize(nr_of_registers);
+        regs = &large_regs[0];
+    }
+
+    for (unsigned int i = 0; i < code.size(); i++)
+    {
+        const Instruction & ins = code[i];
+        switch (ins.op)
+        {
+            case LOAD_CONSTANT: regs[ins.dest] = constants[ins.arg]; break;
+            case LOAD_VARIABLE: regs[ins.dest] = values[ins.arg]; break;
+            case PLUS:          regs[ins.dest] = regs[ins.lhs] + regs[ins.rhs]; break;
+            case MINUS:         regs[ins.dest] = regs[ins.lhs] - regs[ins.rhs]; break;
+            case MULTIPLY:      regs[ins.dest] = regs[ins.lhs] * regs[ins.rhs]; break;
+            case DIVIDE:        regs[ins.dest] = regs[ins.lhs] / regs[ins.rhs]; break;
+            case NEGATE:        regs[ins.dest] = -regs[ins.lhs]; break;
+            default:
+                regs[ins.dest] = apply(ins.op, regs[ins.lhs], is_binary(ins.op) ? regs[ins.rhs] : 0.0, status);
+                if (!status.ok())
+                {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    for (unsigned int o = 0; o < outputs.size(); o++)
+    {
+        results[o] = regs[output_registers[o]];
+    }
+    return true;
+}
+
+/*
+ * evaluate the program for n bindings of the variables at once.
+ * The bindings are processed in blocks: each register is a column holding
+ * the values of a block of bindings, so that the arithmetic operators and
+ * the most common functions are evaluated with vectorized Eigen arrays.
+ * On error, status describes the error and false is returned.
+ */
+bool Program::eval_batch(const double* const values[], const int n, double results[], ErrorStatus & status) const
+{
+    status = ErrorStatus();
+
+    // the rows after the last binding of the last block are not used, but they
+    // are initialized so that the vectorized operations work on valid numbers
+    const int block_size = 256;
+    Eigen::ArrayXXd regs = Eigen::ArrayXXd::Zero(block_size, nr_of_registers);
+
+    for (int begin = 0; begin < n; begin += block_size)
+    {
+        int len = std::min(block_size, n - begin);
+
+        for (unsigned int i = 0; i < code.size(); i++)
+        {
+            const Instruction & ins = code[i];
+            switch (ins.op)
+            {
+                case LOAD_CONSTANT: regs.col(ins.dest).setConstant(constants[ins.arg]); break;
+                case LOAD_VARIABLE: regs.col(ins.dest).head(len) = Eigen::Map<const Eigen::ArrayXd>(values[ins.arg] + begin, len); break;
+                case PLUS:      regs.col(ins.dest) = regs.col(ins.lhs) + regs.col(ins.rhs); break;
+                case MINUS:     regs.col(ins.dest) = regs.col(ins.lhs) - regs.col(ins.rhs); break;
+                case MULTIPLY:  regs.col(ins.dest) = regs.col(ins.lhs) * regs.col(ins.rhs); break;
+                case DIVIDE:    regs.col(ins.dest) = regs.col(ins.lhs) / regs.col(ins.rhs); break;
+                case EQUAL:     regs.col(ins.dest) = (regs.col(ins.lhs) == regs.col(ins.rhs)).cast<double>(); break;
+                case UNEQUAL:   regs.col(ins.dest) = (regs.col(ins.lhs) != regs.col(ins.rhs)).cast<double>(); break;
+                case SMALLER:   regs.col(ins.dest) = (regs.col(ins.lhs) < regs.col(ins.rhs)).cast<double>(); break;
+                case LARGER:    regs.col(ins.dest) = (regs.col(ins.lhs) > regs.col(ins.rhs)).cast<double>(); break;
+                case SMALLEREQ: regs.col(ins.dest) = (regs.col(ins.lhs) <= regs.col(ins.rhs)).cast<double>(); break;
+                case LARGEREQ:  regs.col(ins.dest) = (regs.col(ins.lhs) >= regs.col(ins.rhs)).cast<double>(); break;
+                case NEGATE:    regs.col(ins.dest) = -regs.col(ins.lhs); break;
+                case ABS:       regs.col(ins.dest) = regs.col(ins.lhs).abs(); break;
+                case EXP:       regs.col(ins.dest) = regs.col(ins.lhs).exp(); break;
+                case SQRT:      regs.col(ins.dest) = regs.col(ins.lhs).sqrt(); break;
+                case LOG:       regs.col(ins.dest) = regs.col(ins.lhs).log(); break;
+                case SIN:       regs.col(ins.dest) = regs.col(ins.lhs).sin(); break;
+                case COS:       regs.col(ins.dest) = regs.col(ins.lhs).cos(); break;
+                default:
+                    // the other operators and functions are applied to each binding
+                    for (int k = 0; k < len; k++)
+                    {
+                        regs(k, ins.dest) = apply(ins.op, regs(k, ins.lhs), is_binary(ins.op) ? regs(k, ins.rhs) : 0.0, status);
+                    }
+                    if (!status.ok())
+                    {
+                        return false;
+                    }
+                    break;
+            }
+        }
+
+        for (unsigned int o = 0; o < outputs.size(); o++)
+        {
+            Eigen::Map<Eigen::ArrayXd>(results + o*n + begin, len) = regs.col(output_registers[o]).head(len);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file program.h
+ *
+ * @brief
+ * Compiled expressions: a directed acyclic graph of operations produced by
+ * Parser::compile, that can be evaluated many times without parsing the
+ * expressions again. Constant subexpressions are folded and identical
+ * subexpressions are computed only once, also across the expressions
+ * (outputs) compiled in the same program. Variables are referred by slots,
+ * whose values are passed to eval().
+ *
+ * @license
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy
+ * of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "error.h"
+
+using namespace std;
+
+class Variablelist;
+
+class Program
+{
+    public:
+        enum OPCODE {LOAD_CONSTANT, LOAD_VARIABLE,                      // arg is the constant index or the variable slot
+                     AND, OR, BITSHIFTLEFT, BITSHIFTRIGHT,              // binary operators
+                     EQUAL, UNEQUAL, SMALLER, LARGER, SMALLEREQ, LARGEREQ,
+                     PLUS, MINUS, MULTIPLY, DIVIDE, MODULUS, XOR, POW,
+                     NEGATE, FACTORIAL,                                 // unary operators and functions
+                     ABS, EXP, SIGN, SQRT, LOG, LOG10,
+                     SIN, COS, TAN, ASIN, ACOS, ATAN};
+
+        struct Instruction
+        {
+            int op;     // one of OPCODE
+            int arg;    // constant index or variable slot, 0 otherwise
+            int lhs;    // first operand
+            int rhs;    // second operand of binary operators, -1 otherwise
+            int dest;   // register of the result
+        };
+
+        Program();
+        void clear();
+
+        int get_nr_of_variables() const {return variables.size();}
+        const char* get_variable_name(const int slot) const {return variables[slot].c_str();}
+        int get_variable_slot(const char* name) const;
+
+        // name of the variable assigned by the expression ("x = ..."), empty if none
+        const char* get_assigned_variable() const {return assigned_variable.c_str();}
+
+        int get_nr_of_outputs() const {return outputs.size();}
+
+        int size() const {return code.size();}
+
+        // evaluates the program, returning the value of the last output
+        double eval(const double values[], ErrorStatus & status) const;
+
+        // evaluates the program, storing the value of each output in results
+        bool eval(const double values[], double results[], ErrorStatus & status) const;
+
+        // evaluates the program for n bindings of its variables, given as a
+        // structure of arrays: values[slot][k] is the value of the variable
+        // slot in the binding k, and results[o*n+k] is the corresponding value
+        // of the output o
+        bool eval_batch(const double* const values[], const int n, double results[], ErrorStatus & status) const;
+
+        // builds in derivative the program computing the derivative of each
+        // output with respect to the variable slot. The derivative has the
+        // same variable slots, so it is evaluated with the same values
+        void differentiate(const int slot, Program & derivative) const;
+
+        static int get_function_opcode(const char fn_name[]);
+        static bool is_binary(const int op) {return op >= AND && op <= POW;}
+        static bool is_commutative(const int op);
+        static double apply(const int op, const double lhs, const double rhs, ErrorStatus & status);
+
+    private:
+        friend class Parser;
+        friend class ExpressionCompiler;
+
+        // nodes of the graph are added by the compiler, and are shared
+        // when they are equal to an existing one
+        int add_constant(const double value);
+        int add_variable(const int slot);
+        int add_operation(const int op, const int lhs, const int rhs = -1);
+        void add_output(const int node);
+        void rollback(const int nr_of_nodes, const int nr_of_variables, const int nr_of_outputs);
+        void get_needed_nodes(vector<bool> & needed) const;
+        void schedule();
+
+        // as add_operation, simplifying the operations with the constants 0 and 1
+        int add_derivative_operation(const int op, const int lhs, const int rhs = -1);
+
+        struct NodeKey
+        {
+            int op, lhs, rhs;
+            bool operator<(const NodeKey & other) const;
+        };
+
+        vector<Instruction> nodes;      // nodes of the graph, lhs and rhs are node ids
+        vector<double> constants;
+        map<double, int> constant_nodes;    // node of each constant
+        map<int, int> variable_nodes;       // node of each variable slot
+        map<NodeKey, int> operation_nodes;  // node of each operation
+        vector<int> outputs;            // node of each output
+
+        vector<Instruction> code;       // instructions computing the outputs, lhs and rhs are registers
+        vector<int> output_registers;   // register of each output
+        int nr_of_registers;
+
+        vector<string> variables;       // names of the variable slots
+        vector<int> variable_cols;      // column of the first occurrence of each variable
+        long variable_list_id;          // id of the list of variables used during the compilation, 0 if none
+        vector<int> variable_ids;       // slots of the variables in the list of variable_list_id (-1 if not in the list)
+        string assigned_variable;
+};
+
+#endif
@@ -25,57 +25,98 @@
 
 #include "variablelist.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 /*
- * Returns true if the given name already exists in the variable list
+ * returns a new list id, also if the lists are created by different threads.
+ * The ids start from 1, so 0 can be used for no list
  */
-bool Variablelist::exist(const char* name)
+static long new_list_id()
 {
-    return (get_id(name) != -1);
+#ifdef _WIN32
+    static volatile LONG last_id = 0;
+    return InterlockedIncrement(&last_id);
+#else
+    static long last_id = 0;
+    return __sync_add_and_fetch(&last_id, 1);
+#endif
 }
 
 
 /*
- * Add a name and value to the variable list
+ * constructor, the list is initially empty
  */
-bool Variablelist::add(const char* name, double value)
+Variablelist::Variablelist()
+: list_id(new_list_id())
 {
-    VAR new_var;
-    strncpy(new_var.name, name, 30);
-    new_var.value = value;
+    rehash(16);
+}
 
-    int id = get_id(name);
-    if (id == -1)
-    {
-        // variable does not yet exist
-        var.push_back(new_var);
-    }
-    else
+
+/*
+ * copy constructor, the copy has the same variables in the same slots
+ */
+Variablelist::Variablelist(const Variablelist & other)
+: var(other.var), buckets(other.buckets), list_id(new_list_id())
+{
+}
+
+
+Variablelist & Variablelist::operator=(const Variablelist & other)
+{
+    if (this != &other)
     {
-        // variable already exists. overwrite it
-        var[id] = new_var;
+        var = other.var;
+        buckets = other.buckets;
+        list_id = new_list_id();
     }
-    return true;
+    return *this;
+}
+
+
+/*
+ * Returns true if the given name already exists in the variable list
+ */
+bool Variablelist::exist(const char* name) const
+{
+    return (get_id(name) != -1);
+}
+
+
+/*
+ * Add a name and value to the variable list
+ */
+void Variablelist::add(const char* name, double value)
+{
+    int slot = get_slot(name);
+    var[slot].value = value;
+    var[slot].defined = true;
 }
 
+
 /*
- * Delete given variablename from the variable list
+ * Delete given variablename from the variable list. The slot of the variable
+ * is kept, and it will be used again if the variable is added again
  */
 bool Variablelist::del(const char* name)
 {
     int id = get_id(name);
     if (id != -1)
     {
-        var[id] = var[var.size()-1]; // move last item to deleted item
-        var.pop_back();              // remove last item
+        var[id].defined = false;
+        var[id].value = 0;
         return true;
     }
     return false;
 }
 
+
 /*
  * Get value of variable with given name
  */
-bool Variablelist::get_value(const char* name, double* value)
+bool Variablelist::get_value(const char* name, double* value) const
 {
     int id = get_id(name);
     if (id != -1)
@@ -90,9 +131,9 @@ bool Variablelist::get_value(const char* name, double* value)
 /*
  * Get value of variable with given id
  */
-bool Variablelist::get_value(const int id, double* value)
+bool Variablelist::get_value(const int id, double* value) const
 {
-    if (id >= 0 && id < (int)var.size())
+    if (id >= 0 && id < (int)var.size() && var[id].defined)
     {
         *value = var[id].value;
         return true;
@@ -101,34 +142,141 @@ bool Variablelist::get_value(const int id, double* value)
 }
 
 
-bool Variablelist::set_value(const char* name, const double value)
+void Variablelist::set_value(const char* name, const double value)
 {
-    return add(name, value);
+    add(name, value);
 }
 
+
 /*
- * Returns the id of the given name in the variable list. Returns -1 if name
- * is not present in the list. Name is case insensitive
+ * Returns the id of the given name in the variable list. If the variable does
+ * not exist (or has no value), -1 is returned
  */
-int Variablelist::get_id(const char* name)
+int Variablelist::get_id(const char* name) const
 {
-    // first make the name uppercase
-    char nameU[NAME_LEN_MAX+1];
-    char varU[NAME_LEN_MAX+1];
-    toupper(nameU, name);
+    int slot = find_slot(name, hash(name));
+    if (slot != -1 && var[slot].defined)
+    {
+        return slot;
+    }
+    return -1;
+}
+
+
+/*
+ * Returns the slot of the given name. If the name is not yet in the list, a
+ * new slot without a value is reserved for it
+ */
+int Variablelist::get_slot(const char* name)
+{
+    unsigned int name_hash = hash(name);
+    int slot = find_slot(name, name_hash);
+    if (slot != -1)
+    {
+        return slot;
+    }
 
-    for (unsigned int i = 0; i < var.size(); i++)
+    // keep the load factor of the table below one half
+    if (2 * (var.size() + 1) > buckets.size())
     {
-        toupper(varU, var[i].name);
-        if (strcmp(nameU, varU) == 0)
+        rehash(2 * buckets.size());
+    }
+
+    VAR new_var;
+    new_var.name = name;
+    new_var.key = name;
+    for (unsigned int i = 0; i < new_var.key.size(); i++)
+    {
+        new_var.key[i] = std::toupper(new_var.key[i]);
+    }
+    new_var.hash = name_hash;
+    new_var.value = 0;
+    new_var.defined = false;
+
+    slot = var.size();
+    var.push_back(new_var);
+
+    unsigned int mask = buckets.size() - 1;
+    unsigned int b = name_hash & mask;
+    while (buckets[b] != -1)
+    {
+        b = (b + 1) & mask;
+    }
+    buckets[b] = slot;
+
+    return slot;
+}
+
+
+/*
+ * Returns the slot of the given name, or -1 if the name is not in the list
+ */
+int Variablelist::find_slot(const char* name, const unsigned int name_hash) const
+{
+    unsigned int mask = buckets.size() - 1;
+    for (unsigned int b = name_hash & mask; buckets[b] != -1; b = (b + 1) & mask)
+    {
+        const VAR & candidate = var[buckets[b]];
+        if (candidate.hash == name_hash && equals_no_case(name, candidate.key.c_str()))
         {
-            return i;
+            return buckets[b];
         }
     }
     return -1;
 }
 
 
+/*
+ * Rebuild the hash table with the given number of buckets (a power of two)
+ */
+void Variablelist::rehash(const int nr_of_buckets)
+{
+    buckets.assign(nr_of_buckets, -1);
+    unsigned int mask = nr_of_buckets - 1;
+    for (unsigned int slot = 0; slot < var.size(); slot++)
+    {
+        unsigned int b = var[slot].hash & mask;
+        while (buckets[b] != -1)
+        {
+            b = (b + 1) & mask;
+        }
+        buckets[b] = slot;
+    }
+}
+
+
+/*
+ * FNV-1a hash of the upper case version of name, computed without copying it
+ */
+unsigned int Variablelist::hash(const char* name)
+{
+    unsigned int h = 2166136261u;
+    for (; *name != '\0'; name++)
+    {
+        h ^= (unsigned char)std::toupper(*name);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+/*
+ * Returns true if name is equal to key (that is already upper case),
+ * ignoring the case of name
+ */
+bool Variablelist::equals_no_case(const char* name, const char* key)
+{
+    for (; *name != '\0' && *key != '\0'; name++, key++)
+    {
+        if (std::toupper(*name) != *key)
+        {
+            return false;
+        }
+    }
+    return *name == *key;
+}
+
+
 /*
  * str is copied to upper and made uppercase
  * upper is the returned string
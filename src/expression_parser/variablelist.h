@@ -28,6 +28,7 @@
 #include <cstdio>
 #include <cctype>
 #include <cstring>
+#include <string>
 #include <vector>
 
 #include "constants.h"
@@ -39,25 +40,55 @@ using namespace std;
 void toupper(char upper[], const char str[]);
 
 
+/*
+ * Variables are looked up (case insensitive) in a hash table, and each name
+ * keeps the same slot for the whole life of the list, also after del(): the
+ * slots can then be used by compiled programs to read the values directly.
+ */
 class Variablelist {
     public:
-        bool exist(const char* name);
-        bool add(const char* name, double value);
+        Variablelist();
+        // a copy gets a new id, as its slots can then change independently
+        Variablelist(const Variablelist & other);
+        Variablelist & operator=(const Variablelist & other);
+
+        bool exist(const char* name) const;
+        // the list grows as needed, so adding a variable can not fail
+        void add(const char* name, double value);
         bool del(const char* name);
 
-        bool get_value(const char* name, double* value);
-        bool get_value(const int id, double* value);
-        int  get_id(const char* name);
-        bool set_value(const char* name, const double value);
+        bool get_value(const char* name, double* value) const;
+        bool get_value(const int id, double* value) const;
+        int  get_id(const char* name) const;
+        void set_value(const char* name, const double value);
+
+        // slot of the given name, reserved (without a value) if not yet present
+        int  get_slot(const char* name);
+        // slot of the given name, -1 if not present
+        int  find_slot(const char* name) const {return find_slot(name, hash(name));}
+        int  get_nr_of_slots() const {return var.size();}
+        // unique id of the list, stored in the programs compiled with it
+        long get_list_id() const {return list_id;}
+
+        static unsigned int hash(const char* name);
+        static bool equals_no_case(const char* name, const char* key);
 
     private:
         struct VAR
         {
-            char name[NAME_LEN_MAX+1];
+            string name;
+            string key;         // upper case name
+            unsigned int hash;  // hash of key
             double value;
+            bool defined;       // false for reserved and deleted slots
         };
 
+        int find_slot(const char* name, const unsigned int name_hash) const;
+        void rehash(const int nr_of_buckets);
+
         vector<VAR> var;
+        vector<int> buckets;    // open addressing table of slots, -1 if empty
+        long list_id;
 };
 
 
@@ -0,0 +1,134 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/jacobian.hpp>
+#include <kdl/frames_io.hpp>
+#include <kdl/treefksolverpos_recursive.hpp>
+#include <kdl/treejnttojacsolver.hpp>
+
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+
+//Generated by par2cpp from fake_puma.par at build time
+extern const int fake_puma_kinematics_nr_of_dofs;
+extern const int fake_puma_kinematics_nr_of_links;
+extern const char * const fake_puma_kinematics_link_names[];
+void fake_puma_kinematics(const double * q, double * poses, double * jacobians);
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+int main(int argc, char** argv)
+{
+    srand(time(NULL));
+    if (argc < 2){
+        std::cerr << "Expect the .par file used to generate the kinematics" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    symoro_par_model mdl;
+    if( !parModelFromFile(argv[1],mdl) ) {cerr << "Could not parse SyMoRo par robot model" << endl; return EXIT_FAILURE;}
+
+    Tree my_tree;
+    if( !treeFromParModel(mdl,my_tree,true) ) {cerr << "Could not generate kdl tree" << endl; return EXIT_FAILURE;}
+
+    const int nr_of_dofs = fake_puma_kinematics_nr_of_dofs;
+    const int nr_of_links = fake_puma_kinematics_nr_of_links;
+    if( nr_of_dofs != (int)my_tree.getNrOfJoints() ) {cerr << "Mismatch in the number of DOFs" << endl; return EXIT_FAILURE;}
+
+    TreeFkSolverPos_recursive pos_slv(my_tree);
+    TreeJntToJacSolver jac_slv(my_tree);
+
+    const int nr_of_configurations = 10;
+    double q_range = 3;
+    double tol = 1e-10;
+
+    std::vector<double> q_vec(nr_of_dofs);
+    std::vector<double> poses(12*nr_of_links);
+    std::vector<double> jacobians(6*nr_of_dofs*nr_of_links);
+
+    for(int c=0; c < nr_of_configurations; c++ ) {
+        JntArray q(nr_of_dofs);
+        for(int i=0; i < nr_of_dofs; i++ ) { q(i) = q_vec[i] = q_range*random_double(); }
+
+        fake_puma_kinematics(&q_vec[0],&poses[0],&jacobians[0]);
+
+        for(int l=0; l < nr_of_links; l++ ) {
+            const char * link_name = fake_puma_kinematics_link_names[l];
+            Frame H_kdl;
+            if( pos_slv.JntToCart(q,H_kdl,link_name) != 0 ) { cerr << "Failed geom solver for " << link_name << endl; return EXIT_FAILURE; }
+            Jacobian J_kdl(nr_of_dofs);
+            if( jac_slv.JntToJac(q,J_kdl,link_name) != 0 ) { cerr << "Failed jacobian solver for " << link_name << endl; return EXIT_FAILURE; }
+
+            Frame H_gen;
+            for(int i=0; i < 3; i++ ) {
+                for(int j=0; j < 3; j++ ) {
+                    H_gen.M(i,j) = poses[12*l+3*i+j];
+                }
+                H_gen.p(i) = poses[12*l+9+i];
+            }
+            if( !Equal(H_kdl,H_gen,tol) ) {
+                std::cout << "Pose mismatch for " << link_name << std::endl;
+                std::cout << "H_kdl       " << H_kdl << std::endl;
+                std::cout << "H_generated " << H_gen << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            for(int k=0; k < nr_of_dofs; k++ ) {
+                for(int i=0; i < 6; i++ ) {
+                    if( fabs(J_kdl(i,k)-jacobians[6*(nr_of_dofs*l+k)+i]) > tol ) {
+                        std::cout << "Jacobian mismatch for " << link_name << " at (" << i << "," << k << "): "
+                                  << J_kdl(i,k) << " instead of " << jacobians[6*(nr_of_dofs*l+k)+i] << std::endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
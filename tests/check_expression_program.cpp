@@ -0,0 +1,406 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include "parser.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+bool checkValue(const char * expr, const double value, const double expected, double tol = 1e-12)
+{
+    if( fabs(value-expected) > tol ) {
+        std::cout << "Mismatch for " << expr << ": " << value << " instead of " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+const int nr_of_evals = 1000;
+
+struct thread_data
+{
+    const Parser * prs;
+    const Program * program;
+    int nr_of_wrong_evals;
+};
+
+/**
+ * Evaluate the shared program and another expression with the const functions of the parser.
+ * r is not defined, so only the evaluation of the second expression succeeds
+ */
+void * evaluateShared(void * arg)
+{
+    thread_data & data = *static_cast<thread_data *>(arg);
+    ParserContext context;
+    ErrorStatus status_shared, status_other;
+    const char * other_expr = "q*3 + 1";
+    for(int i=0; i < nr_of_evals; i++ ) {
+        data.prs->eval(*data.program,status_shared,context);
+        double val = data.prs->evaluate(other_expr,other_expr+strlen(other_expr),status_other,context);
+        if( status_shared.id != 103 || !status_other.ok() || fabs(val-1.75) > 1e-12 ) data.nr_of_wrong_evals++;
+    }
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    Parser prs;
+    ErrorStatus status;
+
+    //A compiled program gives the same results of the interpreter
+    const char * exprs[] = {"t1+Pi/2", "-t2^2*3 - 0.5", "sin(t1)*cos(t2)+SQRT(abs(t1*t2))", "(t1<t2) + 7%3 + 3!", "2.5e-3*t2/(1+t1^2)"};
+    const int nr_of_exprs = sizeof(exprs)/sizeof(exprs[0]);
+
+    for(int i=0; i < nr_of_exprs; i++ ) {
+        Program program;
+        if( !prs.compile(exprs[i],program,status) ) {
+            std::cout << "Could not compile " << exprs[i] << ": " << status.msg << std::endl;
+            return EXIT_FAILURE;
+        }
+        int t1_slot = program.get_variable_slot("t1");
+        int t2_slot = program.get_variable_slot("T2");
+        if( program.get_nr_of_variables() != (t1_slot >= 0) + (t2_slot >= 0) ) {
+            std::cout << "Wrong variable slots for " << exprs[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        for(int k=0; k < 20; k++ ) {
+            double values[2];
+            if( t1_slot >= 0 ) values[t1_slot] = 0.1*k-1.0;
+            if( t2_slot >= 0 ) values[t2_slot] = 0.3*k+0.2;
+            prs.user_var.add("t1",0.1*k-1.0);
+            prs.user_var.add("t2",0.3*k+0.2);
+
+            double expected = prs.evaluate(exprs[i],status);
+            if( !status.ok() ) { std::cout << "Could not evaluate " << exprs[i] << std::endl; return EXIT_FAILURE; }
+            if( !checkValue(exprs[i],program.eval(values,status),expected) || !status.ok() ) return EXIT_FAILURE;
+            if( !checkValue(exprs[i],prs.eval(program,status),expected) || !status.ok() ) return EXIT_FAILURE;
+        }
+    }
+
+    if( !checkValue("t1+Pi/2",prs.evaluate("t1 = 1+Pi/2",status),1+M_PI/2) || !status.ok() ) return EXIT_FAILURE;
+    if( !checkValue("t1",prs.evaluate("t1",status),1+M_PI/2) || !status.ok() ) return EXIT_FAILURE;
+
+    //Errors are reported both by compile and by the evaluation
+    Program program;
+    const char * wrong_exprs[] = {"1+", "(1+2", "1//2", "foo(3)", "1 2", "$"};
+    for(int i=0; i < (int)(sizeof(wrong_exprs)/sizeof(wrong_exprs[0])); i++ ) {
+        if( prs.compile(wrong_exprs[i],program,status) || status.ok() ) {
+            std::cout << "Compiled wrong expression " << wrong_exprs[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if( !prs.compile("unknown+1",program,status) ) return EXIT_FAILURE;
+    prs.eval(program,status);
+    if( status.id != 103 ) { std::cout << "Unknown variable not detected" << std::endl; return EXIT_FAILURE; }
+    if( !prs.compile("1.5!",program,status) ) return EXIT_FAILURE;
+    prs.eval(program,status);
+    if( status.id != 400 ) { std::cout << "Wrong factorial not detected" << std::endl; return EXIT_FAILURE; }
+
+    //Many variables, case insensitive and with slots that do not change after a del
+    Parser many_prs;
+    const int nr_of_vars = 1000;
+    for(int i=0; i < nr_of_vars; i++ ) {
+        char name[32];
+        sprintf(name,"t%d",i);
+        many_prs.user_var.add(name,i);
+    }
+    if( !many_prs.compile("T10*t999 + t0",program,status) ) return EXIT_FAILURE;
+    if( !checkValue("T10*t999 + t0",many_prs.eval(program,status),9990) || !status.ok() ) return EXIT_FAILURE;
+    int slot = many_prs.user_var.get_id("t500");
+    if( slot != many_prs.user_var.get_id("T500") || !many_prs.user_var.del("t500") || many_prs.user_var.exist("t500") ) {
+        std::cout << "Wrong case insensitive lookup or del" << std::endl;
+        return EXIT_FAILURE;
+    }
+    many_prs.user_var.add("t1001",-1);
+    many_prs.user_var.add("T500",5);
+    if( many_prs.user_var.get_id("t500") != slot ) {
+        std::cout << "Slot of a variable changed after a del" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if( !checkValue("t500",many_prs.evaluate("t500",status),5) || !status.ok() ) return EXIT_FAILURE;
+
+    //Long expressions and names, and expressions that are not null-terminated
+    std::string long_name(100,'x');
+    std::string long_expr = long_name + " = 0";
+    for(int i=1; i <= 500; i++ ) {
+        long_expr += " + 0.5";
+    }
+    if( !checkValue("long expression",prs.evaluate(long_expr.c_str(),status),250) || !status.ok() ) return EXIT_FAILURE;
+    if( !checkValue("long name",prs.evaluate((long_name+"*2").c_str(),status),500) || !status.ok() ) return EXIT_FAILURE;
+    const char * list = "1+2,34";
+    if( !checkValue("range",prs.evaluate(list,list+3,status),3) || !status.ok() ) return EXIT_FAILURE;
+    if( !checkValue("range",prs.evaluate(list+4,list+5,status),3) || !status.ok() ) return EXIT_FAILURE;
+
+    //A program compiled once can be evaluated concurrently with the const functions,
+    //that do not modify the parser and its variables
+    Parser shared_prs;
+    shared_prs.user_var.add("q",0.25);
+    int nr_of_slots = shared_prs.user_var.get_nr_of_slots();
+    Program shared_program;
+    ParserContext compile_context;
+    const char * shared_expr = "sin(q)*r + 2";
+    if( !shared_prs.compile(shared_expr,shared_expr+strlen(shared_expr),shared_program,status,compile_context) ) return EXIT_FAILURE;
+
+#ifndef _WIN32
+    const int nr_of_threads = 4;
+    pthread_t threads[nr_of_threads];
+    thread_data data[nr_of_threads];
+    for(int t=0; t < nr_of_threads; t++ ) {
+        data[t].prs = &shared_prs;
+        data[t].program = &shared_program;
+        data[t].nr_of_wrong_evals = 0;
+        if( pthread_create(&threads[t],0,evaluateShared,&data[t]) != 0 ) { std::cout << "Could not create thread " << t << std::endl; return EXIT_FAILURE; }
+    }
+    int nr_of_wrong_evals = 0;
+    for(int t=0; t < nr_of_threads; t++ ) {
+        pthread_join(threads[t],0);
+        nr_of_wrong_evals += data[t].nr_of_wrong_evals;
+    }
+    if( nr_of_wrong_evals != 0 ) {
+        std::cout << "Wrong concurrent evaluation" << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+    shared_prs.user_var.add("r",4);
+    ParserContext context;
+    if( !checkValue(shared_expr,shared_prs.eval(shared_program,status,context),sin(0.25)*4+2) || !status.ok() ) return EXIT_FAILURE;
+    if( shared_prs.user_var.get_nr_of_slots() != nr_of_slots+1 || shared_prs.user_var.exist("Ans") ) {
+        std::cout << "The variables were modified by the const functions" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Constant subexpressions are folded, and equal subexpressions are computed once
+    if( !prs.compile("t1 * (Pi/2*sqrt(4) - 2^3)",program,status) ) return EXIT_FAILURE;
+    if( program.size() != 3 ) {
+        std::cout << "Constants not folded: " << program.size() << " instructions" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if( !prs.compile("sin(t1)*t2 + t2*sin(t1) + sin(T1)",program,status) ) return EXIT_FAILURE;
+    if( program.size() != 6 ) {
+        std::cout << "Common subexpressions not shared: " << program.size() << " instructions" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Many expressions compiled in the same program share their subexpressions
+    const char * output_exprs[] = {"cos(t1)*t2", "-sin(t1)*t2", "t2*cos(t1) + 1", "Pi"};
+    const int nr_of_outputs = sizeof(output_exprs)/sizeof(output_exprs[0]);
+    program.clear();
+    for(int i=0; i < nr_of_outputs; i++ ) {
+        if( !prs.compile_output(output_exprs[i],output_exprs[i]+strlen(output_exprs[i]),program,status) ) return EXIT_FAILURE;
+    }
+    const char * wrong_output = "t1 + t3 +";
+    if( prs.compile_output(wrong_output,wrong_output+strlen(wrong_output),program,status) ||
+        program.get_nr_of_outputs() != nr_of_outputs || program.get_nr_of_variables() != 2 || program.size() != 10 ) {
+        std::cout << "Wrong program with many outputs" << std::endl;
+        return EXIT_FAILURE;
+    }
+    double output_values[2], outputs[nr_of_outputs];
+    output_values[program.get_variable_slot("t1")] = 0.3;
+    output_values[program.get_variable_slot("t2")] = 2;
+    if( !program.eval(output_values,outputs,status) ) return EXIT_FAILURE;
+    for(int i=0; i < nr_of_outputs; i++ ) {
+        prs.user_var.add("t1",0.3);
+        prs.user_var.add("t2",2);
+        if( !checkValue(output_exprs[i],outputs[i],prs.evaluate(output_exprs[i],status)) ) return EXIT_FAILURE;
+    }
+    double parser_outputs[nr_of_outputs];
+    if( !prs.eval(program,parser_outputs,status) || !checkValue("Pi",parser_outputs[nr_of_outputs-1],M_PI) ) return EXIT_FAILURE;
+
+    //A program is bound only to the variables of the parser that compiled it, also if
+    //another parser is created at the same address, and can be extended by another parser
+    Program moved_program;
+    Parser * old_prs = new Parser;
+    old_prs->user_var.add("a",1);
+    old_prs->user_var.add("b",2);
+    if( !old_prs->compile("b",moved_program,status) ) return EXIT_FAILURE;
+    old_prs->~Parser();
+    Parser * new_prs = new (old_prs) Parser;
+    new_prs->user_var.add("b",5);
+    if( !checkValue("b",new_prs->eval(moved_program,status),5) || !status.ok() ) return EXIT_FAILURE;
+    const char * moved_output = "b*2 + a";
+    if( !new_prs->compile_output(moved_output,moved_output+strlen(moved_output),moved_program,status) ||
+        moved_program.get_nr_of_outputs() != 2 || moved_program.get_nr_of_variables() != 2 ) {
+        std::cout << "Wrong program extended by another parser" << std::endl;
+        return EXIT_FAILURE;
+    }
+    new_prs->user_var.add("a",3);
+    double moved_outputs[2];
+    if( !new_prs->eval(moved_program,moved_outputs,status) ||
+        !checkValue("b",moved_outputs[0],5) || !checkValue(moved_output,moved_outputs[1],13) ) return EXIT_FAILURE;
+    delete new_prs;
+
+    //A whole list is compiled in a single program, with an output for each element
+    const char * list_expr = "{0, Pi/2,\n  -Pi/2, t1*2,\r\n (t1*2)+1 }";
+    std::vector<double> list_values;
+    if( !prs.compile_list(list_expr,list_expr+strlen(list_expr),program,status) ||
+        program.get_nr_of_outputs() != 5 || program.size() != 8 ) {
+        std::cout << "Wrong compiled list" << std::endl;
+        return EXIT_FAILURE;
+    }
+    prs.user_var.add("t1",3);
+    if( !prs.evaluate_list(list_expr,list_expr+strlen(list_expr),list_values,status) || list_values.size() != 5 ) return EXIT_FAILURE;
+    const double expected_list[] = {0, M_PI/2, -M_PI/2, 6, 7};
+    for(int i=0; i < 5; i++ ) {
+        if( !checkValue(list_expr,list_values[i],expected_list[i]) ) return EXIT_FAILURE;
+    }
+    const char * empty_list = " { } ";
+    if( !prs.evaluate_list(empty_list,empty_list+strlen(empty_list),list_values,status) || !list_values.empty() ) return EXIT_FAILURE;
+    const char * wrong_lists[] = {"1,2", "{1,2", "{1,2} 3", "{1,,2}", "{1 2}"};
+    const int wrong_list_ids[] = {8, 9, 5, 7, 5};
+    for(int i=0; i < (int)(sizeof(wrong_lists)/sizeof(wrong_lists[0])); i++ ) {
+        if( prs.evaluate_list(wrong_lists[i],wrong_lists[i]+strlen(wrong_lists[i]),list_values,status) || status.id != wrong_list_ids[i] ) {
+            std::cout << "Wrong list " << wrong_lists[i] << " not detected: " << status.id << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    //The derivatives of the outputs agree with the finite differences
+    const char * diff_exprs[] = {"sin(t1)*cos(t2)/(1+t1^2) - exp(-t1*t2)", "sqrt(abs(t1)) + log(t2)*t1 - tan(t1/3) + t2^t1",
+                                 "asin(t1/2) + acos(t1/3)*atan(t2) + log10(t2) - 7", "(t1 < t2)*t1 + 3!"};
+    const int nr_of_diff_exprs = sizeof(diff_exprs)/sizeof(diff_exprs[0]);
+    program.clear();
+    for(int i=0; i < nr_of_diff_exprs; i++ ) {
+        if( !prs.compile_output(diff_exprs[i],diff_exprs[i]+strlen(diff_exprs[i]),program,status) ) return EXIT_FAILURE;
+    }
+    int diff_slots[2] = {program.get_variable_slot("t1"), program.get_variable_slot("t2")};
+    for(int v=0; v < 2; v++ ) {
+        Program derivative;
+        program.differentiate(diff_slots[v],derivative);
+        double diff_values[2] = {0.7, 1.3};
+        double derivatives[nr_of_diff_exprs], plus[nr_of_diff_exprs], minus[nr_of_diff_exprs];
+        const double h = 1e-6;
+        if( derivative.get_nr_of_outputs() != nr_of_diff_exprs || !derivative.eval(diff_values,derivatives,status) ) return EXIT_FAILURE;
+        diff_values[diff_slots[v]] += h;
+        if( !program.eval(diff_values,plus,status) ) return EXIT_FAILURE;
+        diff_values[diff_slots[v]] -= 2*h;
+        if( !program.eval(diff_values,minus,status) ) return EXIT_FAILURE;
+        for(int i=0; i < nr_of_diff_exprs; i++ ) {
+            if( !checkValue(diff_exprs[i],derivatives[i],(plus[i]-minus[i])/(2*h),1e-6) ) return EXIT_FAILURE;
+        }
+    }
+    Program derivative;
+    if( !prs.compile("t1*t1*5 + t2",program,status) ) return EXIT_FAILURE;
+    program.differentiate(program.get_variable_slot("t2"),derivative);
+    if( derivative.size() != 1 ) {
+        std::cout << "Derivative not simplified: " << derivative.size() << " instructions" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Batch evaluation over many bindings of the variables gives the same results of eval
+    const char * batch_exprs[] = {"0.5*sin(D3)*cos(RL4) + exp(-D3*D3) - RL4/3 + sqrt(abs(D3))",
+                                  "(D3 < RL4) + log(RL4) - tan(D3/10) + 3! + D3^2", "Pi"};
+    const int nr_of_bindings = 1000;
+    std::vector<double> d3(nr_of_bindings), rl4(nr_of_bindings), results(nr_of_bindings);
+    for(int k=0; k < nr_of_bindings; k++ ) {
+        d3[k] = 0.007*k-3;
+        rl4[k] = 1+0.003*k;
+    }
+    for(int i=0; i < 3; i++ ) {
+        Program batch_program;
+        if( !prs.compile(batch_exprs[i],batch_program,status) ) return EXIT_FAILURE;
+        const double * batch_values[2];
+        int d3_slot = batch_program.get_variable_slot("D3");
+        int rl4_slot = batch_program.get_variable_slot("RL4");
+        if( d3_slot >= 0 ) batch_values[d3_slot] = &d3[0];
+        if( rl4_slot >= 0 ) batch_values[rl4_slot] = &rl4[0];
+        if( !batch_program.eval_batch(batch_values,nr_of_bindings,&results[0],status) ) return EXIT_FAILURE;
+        for(int k=0; k < nr_of_bindings; k++ ) {
+            double values[2];
+            if( d3_slot >= 0 ) values[d3_slot] = d3[k];
+            if( rl4_slot >= 0 ) values[rl4_slot] = rl4[k];
+            if( !checkValue(batch_exprs[i],results[k],batch_program.eval(values,status),1e-10) ) return EXIT_FAILURE;
+        }
+    }
+
+    //Microbenchmark of the batch evaluation against the evaluation of one binding at a time
+    {
+        const int nr_of_repetitions = 200;
+        double checksum[2] = {0,0};
+        Program batch_program;
+        if( !prs.compile(batch_exprs[0],batch_program,status) ) return EXIT_FAILURE;
+        const double * batch_values[2];
+        batch_values[batch_program.get_variable_slot("D3")] = &d3[0];
+        batch_values[batch_program.get_variable_slot("RL4")] = &rl4[0];
+
+        clock_t start = clock();
+        for(int r=0; r < nr_of_repetitions; r++ ) {
+            if( !batch_program.eval_batch(batch_values,nr_of_bindings,&results[0],status) ) return EXIT_FAILURE;
+            for(int k=0; k < nr_of_bindings; k++ ) { checksum[0] += results[k]; }
+        }
+        double batch_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        start = clock();
+        for(int r=0; r < nr_of_repetitions; r++ ) {
+            for(int k=0; k < nr_of_bindings; k++ ) {
+                double values[2];
+                values[batch_program.get_variable_slot("D3")] = d3[k];
+                values[batch_program.get_variable_slot("RL4")] = rl4[k];
+                checksum[1] += batch_program.eval(values,status);
+            }
+        }
+        double scalar_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        std::cout << "Evaluated " << nr_of_bindings*nr_of_repetitions << " bindings: eval_batch " << batch_time
+                  << " s, eval " << scalar_time << " s" << std::endl;
+        if( fabs(checksum[0]-checksum[1]) > 1e-8*fabs(checksum[1]) ) {
+            std::cout << "The checksum of eval_batch differs from the one of eval" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( !prs.compile("D3!",program,status) ) return EXIT_FAILURE;
+    const double * d3_values = &d3[0];
+    if( program.eval_batch(&d3_values,nr_of_bindings,&results[0],status) || status.id != 400 ) {
+        std::cout << "Wrong factorial not detected in batch evaluation" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include "numeric_scanner.hpp"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <clocale>
+#include <cmath>
+#include <cctype>
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace kdl_format_io;
+
+/**
+ * Check that the number at the beginning of text is scanned with the same
+ * value (bit by bit) and length of strtod in the C locale
+ */
+bool checkAsStrtod(const std::string & text)
+{
+    char * strtod_end;
+    double expected = strtod(text.c_str(),&strtod_end);
+    double value;
+    const char * end = scanDouble(text.c_str(),text.c_str()+text.size(),value);
+    if( memcmp(&value,&expected,sizeof(double)) != 0 || end != strtod_end ) {
+        std::cout << "Mismatch for " << text << ": " << value << " (" << end-text.c_str() << " characters) instead of "
+                  << expected << " (" << strtod_end-text.c_str() << " characters)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Extract the numbers in the content of a file
+ */
+void extractNumbers(const std::string & content, std::vector<std::string> & numbers)
+{
+    const char * p = content.c_str();
+    while( *p ) {
+        bool starts_number = (*p >= '0' && *p <= '9') || (*p == '.' && p[1] >= '0' && p[1] <= '9');
+        bool after_name = p > content.c_str() && (isalnum((unsigned char)p[-1]) || p[-1] == '_' || p[-1] == '.');
+        if( starts_number && !after_name ) {
+            double value;
+            const char * end = scanDouble(p,0,value);
+            numbers.push_back(std::string(p,end));
+            p = end;
+        } else {
+            p++;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool ok = true;
+
+    //Edge cases
+    const char * cases[] = {"0", "-0", "+1", "12", "-0.5", ".25", "5.", "2.3e-4", "1.23E50", "1e", "1e+", "2.5e-x",
+                            "0.1", "0.3", "123456789012345678", "9007199254740993", "12345678901234567890123",
+                            "1e22", "1e23", "4.35679e-23", "2.2250738585072014e-308", "4.9e-324", "1.7976931348623157e308",
+                            "1e400", "0.000000000000000000000000000001", "3.14159265358979323846264338327950288",
+                            "1.2.3", "7 8", "00012.500"};
+    for(size_t i=0; i < sizeof(cases)/sizeof(cases[0]); i++ ) {
+        ok = checkAsStrtod(cases[i]) && ok;
+    }
+
+    double value = 1;
+    const char * no_number = "abc";
+    if( scanDouble(no_number,0,value) != no_number || value != 0 ) {
+        std::cout << "A number was found in " << no_number << std::endl;
+        ok = false;
+    }
+    const char * dot = ".";
+    if( scanDouble(dot,0,value) != dot ) {
+        std::cout << "A number was found in " << dot << std::endl;
+        ok = false;
+    }
+
+    //The end of the range is respected
+    const char * range = "12345";
+    if( scanDouble(range,range+3,value) != range+3 || value != 123 ) {
+        std::cout << "The end of the range is not respected" << std::endl;
+        ok = false;
+    }
+
+    int int_value = 0;
+    const char * int_text = "-42,";
+    if( scanInt(int_text,0,int_value) != int_text+3 || int_value != -42 ) {
+        std::cout << "Wrong integer for " << int_text << std::endl;
+        ok = false;
+    }
+    const char * overflow = "12345678901";
+    if( scanInt(overflow,0,int_value) != overflow ) {
+        std::cout << "Overflow not detected for " << overflow << std::endl;
+        ok = false;
+    }
+
+    //Numbers printed with different precisions
+    srand(0);
+    char buffer[64];
+    for(int i=0; i < 100000; i++ ) {
+        double random_value = ((double)rand()/RAND_MAX-0.5)*pow(10.0,(rand()%40)-20);
+        const char * formats[] = {"%.17g", "%.6g", "%.3f", "%e"};
+        sprintf(buffer,formats[i%4],random_value);
+        if( !checkAsStrtod(buffer) ) {
+            ok = false;
+            break;
+        }
+    }
+
+    //Numbers of the files passed as arguments
+    std::vector<std::string> numbers;
+    for(int i=1; i < argc; i++ ) {
+        std::ifstream ifs(argv[i]);
+        std::string content( (std::istreambuf_iterator<char>(ifs) ), (std::istreambuf_iterator<char>()) );
+        if( content.empty() ) {
+            std::cerr << "Could not read " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+        extractNumbers(content,numbers);
+    }
+    for(size_t i=0; i < numbers.size(); i++ ) {
+        ok = checkAsStrtod(numbers[i]) && ok;
+    }
+
+    //The decimal separator of the locale is ignored
+    if( setlocale(LC_NUMERIC,"de_DE.UTF-8") || setlocale(LC_NUMERIC,"it_IT.UTF-8") ) {
+        const char * decimal = "1.25e2";
+        if( scanDouble(decimal,0,value) != decimal+6 || value != 125 ) {
+            std::cout << "The locale changed the value of " << decimal << std::endl;
+            ok = false;
+        }
+        setlocale(LC_NUMERIC,"C");
+    }
+
+    //Microbenchmark on the numbers of the files
+    if( !numbers.empty() ) {
+        const int nr_of_repetitions = 200;
+        double checksum[3] = {0,0,0};
+
+        clock_t start = clock();
+        for(int r=0; r < nr_of_repetitions; r++ ) {
+            for(size_t i=0; i < numbers.size(); i++ ) {
+                scanDouble(numbers[i].c_str(),numbers[i].c_str()+numbers[i].size(),value);
+                checksum[0] += value;
+            }
+        }
+        double scanner_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        start = clock();
+        for(int r=0; r < nr_of_repetitions; r++ ) {
+            for(size_t i=0; i < numbers.size(); i++ ) {
+                checksum[1] += strtod(numbers[i].c_str(),0);
+            }
+        }
+        double strtod_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        start = clock();
+        for(int r=0; r < nr_of_repetitions; r++ ) {
+            for(size_t i=0; i < numbers.size(); i++ ) {
+                std::istringstream iss(numbers[i]);
+                iss >> value;
+                checksum[2] += value;
+            }
+        }
+        double stream_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        std::cout << "Scanned " << numbers.size()*nr_of_repetitions << " numbers: scanDouble " << scanner_time
+                  << " s, strtod " << strtod_time << " s, istringstream " << stream_time << " s" << std::endl;
+        if( checksum[0] != checksum[1] ) {
+            std::cout << "The checksum of scanDouble differs from the one of strtod" << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,164 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include <kdl_format_io/symoro_par_import.hpp>
+#include <kdl_format_io/symoro_par_import_serialization.hpp>
+#include <kdl_format_io/symoro_code_evaluator.hpp>
+
+#include <kdl_codyco/treeinertialparameters.hpp>
+
+#include <ctime>
+#include <cstdio>
+
+#include <kdl/frames_io.hpp>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+using namespace KDL::CoDyCo;
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+#include "symoro_generated_fake_puma_regressor.cpp"
+
+void setJointInputs(symoro_code_evaluator & evaluator, const JntArray & q, const JntArray & dq, const JntArray & ddq)
+{
+    char name[64];
+    for(int i=0; i < q.rows(); i++ ) {
+        sprintf(name,"q(%d)",i);
+        evaluator.setInput(name,q(i));
+        sprintf(name,"q_dot(%d)",i);
+        evaluator.setInput(name,dq(i));
+        sprintf(name,"q_dotdot(%d)",i);
+        evaluator.setInput(name,ddq(i));
+    }
+}
+
+int main(int argc, char** argv)
+{
+  srand(time(NULL));
+  if (argc < 4){
+    std::cerr << "Expect the fake puma generated code, the HRP2 .par file and the HRP2 generated code" << std::endl;
+    return -1;
+  }
+
+  double tol = 1e-3;
+
+  //The runtime evaluation of the generated code must be equal to the compiled one
+  symoro_code_evaluator puma_evaluator;
+  if( !puma_evaluator.loadFromFile(argv[1]) ) {cerr << "Could not load the fake puma generated code" << endl; return EXIT_FAILURE;}
+
+  JntArray q(6), dq(6), ddq(6);
+  for(int i=0; i < 6; i++ ) {
+      q(i) = 3*random_double();
+      dq(i) = random_double();
+      ddq(i) = random_double();
+  }
+  double g = 9.8;
+
+  Eigen::MatrixXd regr_compiled(6,7*10), regr_runtime;
+  if( symoro_generated_fake_puma_regressor(q,dq,ddq,g,regr_compiled) != 0 ) { cout << "SyMoRo regressor failed " << endl; return EXIT_FAILURE; }
+  setJointInputs(puma_evaluator,q,dq,ddq);
+  puma_evaluator.setInput("g",g);
+  puma_evaluator.evaluate();
+  if( !puma_evaluator.getOutput("dynamics_regressor",regr_runtime) ) { cout << "Runtime regressor failed " << endl; return EXIT_FAILURE; }
+
+  if( regr_runtime.rows() != regr_compiled.rows() || regr_runtime.cols() != regr_compiled.cols() ||
+      (regr_runtime-regr_compiled).cwiseAbs().maxCoeff() > 1e-10 ) {
+      cout << "Mismatch between compiled and runtime fake puma regressor" << endl; return EXIT_FAILURE;
+  }
+
+  //The HRP2 generated code is too big to be compiled in Release, so it is checked only at runtime against KDL
+  Tree my_tree;
+  TreeSerialization serialization;
+  if (!treeAndSerializationFromSymoroParFile(argv[2],my_tree,serialization,true))
+  {cerr << "Could not generate robot model and extract kdl tree" << endl; return EXIT_FAILURE;}
+
+  symoro_code_evaluator hrp2_evaluator;
+  if( !hrp2_evaluator.loadFromFile(argv[3]) ) {cerr << "Could not load the HRP2 generated code" << endl; return EXIT_FAILURE;}
+  std::cout << "HRP2 regressor evaluated with " << hrp2_evaluator.getNrOfOperations() << " operations" << std::endl;
+
+  int nj = my_tree.getNrOfJoints();
+  q = dq = ddq = JntArray(nj);
+  for(int i=0; i < nj; i++ ) {
+      q(i) = random_double();
+      dq(i) = random_double();
+      ddq(i) = random_double();
+  }
+  Twist base_vel = Twist(Vector(1.0,0.0,0.0),Vector(0.0,0.0,1.0));
+  Twist base_acc = Twist(Vector(random_double(),random_double(),random_double()),Vector(random_double(),random_double(),random_double()));
+  Vector base_lin_acc_classical = base_acc.vel + base_vel.rot*base_vel.vel;
+
+  setJointInputs(hrp2_evaluator,q,dq,ddq);
+  for(int k=0; k < 3; k++ ) {
+      char name[64];
+      sprintf(name,"base_vel.rot[%d]",k);
+      hrp2_evaluator.setInput(name,base_vel.rot[k]);
+      sprintf(name,"base_acc.rot[%d]",k);
+      hrp2_evaluator.setInput(name,base_acc.rot[k]);
+      sprintf(name,"base_lin_acc_classical[%d]",k);
+      hrp2_evaluator.setInput(name,base_lin_acc_classical[k]);
+  }
+  hrp2_evaluator.evaluate();
+
+  int np = (my_tree.getNrOfSegments()+1)*10;
+  Eigen::MatrixXd regr_symoro(6,np);
+  if( !hrp2_evaluator.getOutput("dynamics_regressor",regr_symoro) ) { cout << "Runtime regressor failed " << endl; return EXIT_FAILURE; }
+
+  TreeInertialParametersRegressor slv(my_tree,Vector::Zero(),serialization);
+  Eigen::MatrixXd fb_regr_dirl(nj+6,np);
+  fb_regr_dirl.setZero();
+  if( slv.dynamicsRegressor(q,dq,ddq,base_vel,base_acc,fb_regr_dirl) != 0 ) { cout << "fb dirl regressor failed" << endl; return EXIT_FAILURE; }
+
+  Eigen::MatrixXd regr_dirl = fb_regr_dirl.block(0,0,6,np);
+  //Symoro doesn't generate the regressor for the base link
+  regr_dirl.block(0,0,6,10).setZero();
+
+  for(int i=0; i < regr_dirl.rows(); i++ ) {
+      for(int j=0; j < regr_dirl.cols(); j++ ) {
+          double err = fabs(regr_dirl(i,j)-regr_symoro(i,j));
+          if( err > tol ) {
+              std::cout << "Error element " << i << " " << j << " is " << err << " abs(" << regr_dirl(i,j) << " - " << regr_symoro(i,j) << " )"<< std::endl;
+              return EXIT_FAILURE;
+          }
+      }
+  }
+
+  return EXIT_SUCCESS;
+}
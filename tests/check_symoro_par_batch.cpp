@@ -0,0 +1,211 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+#include <kdl_format_io/symoro_par_batch.hpp>
+#include <kdl_format_io/symoro_par_expression_cache.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl/frames_io.hpp>
+
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+int main(int argc, char** argv)
+{
+    srand(time(NULL));
+    if (argc < 2){
+        std::cerr << "Expect .par file to parse" << std::endl;
+        return -1;
+    }
+
+    symoro_par_model mdl;
+    if( !parModelFromFile(argv[1],mdl) ) {cerr << "Could not parse SyMoRo par robot model" << endl; return EXIT_FAILURE;}
+
+    //The expressions of a model imported again are all found in a shared cache
+    symoro_par_expression_cache cache;
+    symoro_par_model cached_mdl;
+    if( !parModelFromFile(argv[1],cached_mdl,&cache) || cache.getNrOfHits() != 0 ) {cerr << "Could not parse with the cache" << endl; return EXIT_FAILURE;}
+    long nr_of_lookups = cache.getNrOfLookups();
+    if( !parModelFromFile(argv[1],cached_mdl,&cache) || cache.getNrOfLookups() != 2*nr_of_lookups ||
+        cache.getNrOfHits() != nr_of_lookups || cached_mdl.toString() != mdl.toString() ) {
+        cerr << "Wrong model imported with the cache, hit rate " << cache.getHitRate() << endl; return EXIT_FAILURE;
+    }
+    symoro_par_expression_cache small_cache(2);
+    if( !parModelFromFile(argv[1],cached_mdl,&small_cache) || small_cache.getNrOfExpressions() > 2 ||
+        cached_mdl.toString() != mdl.toString() ) {
+        cerr << "Wrong model imported with a bounded cache" << endl; return EXIT_FAILURE;
+    }
+
+    symoro_par_batch batch(mdl);
+    if( !batch.isValid() ) {cerr << "Could not create batch instantiation" << endl; return EXIT_FAILURE;}
+
+    //Perturb d, R, Alpha and the offset of Theta of all the links
+    const int fields[] = { symoro_par_model::D_FIELD, symoro_par_model::R_FIELD, symoro_par_model::ALPHA_FIELD, symoro_par_batch::THETA_FIELD };
+    for(int l=0; l < mdl.NL; l++ ) {
+        for(int f=0; f < 4; f++ ) {
+            char name[32];
+            sprintf(name,"P%d_%d",f,l+1);
+            if( batch.addParameter(name,l,fields[f]) < 0 ) {cerr << "Could not add parameter " << name << endl; return EXIT_FAILURE;}
+        }
+    }
+
+    std::vector<double> nominal;
+    batch.getNominalParameters(nominal);
+    const int nr_of_parameters = batch.getNrOfParameters();
+    const int nr_of_instances = 20;
+    double perturbation = 0.01;
+    double tol = 1e-10;
+
+    std::vector<double> values(nr_of_instances*nr_of_parameters);
+    for(int i=0; i < nr_of_instances; i++ ) {
+        for(int p=0; p < nr_of_parameters; p++ ) {
+            values[i*nr_of_parameters+p] = nominal[p] + perturbation*random_double();
+        }
+    }
+
+    std::vector<symoro_par_model> models;
+    std::vector<Tree> trees;
+    if( !batch.instantiateModels(&values[0],nr_of_instances,models) ||
+        !batch.instantiateTrees(&values[0],nr_of_instances,trees) ) {
+        cerr << "Batch instantiation failed" << endl; return EXIT_FAILURE;
+    }
+
+    for(int i=0; i < nr_of_instances; i++ ) {
+        for(int l=0; l < mdl.NL; l++ ) {
+            const double * instance_values = &values[i*nr_of_parameters+4*l];
+            if( models[i].d[l] != instance_values[0] || models[i].R[l] != instance_values[1] ||
+                models[i].Alpha[l] != instance_values[2] || models[i].Theta[l] != instance_values[3] ) {
+                cerr << "Mismatch in the parameters of instance " << i << endl; return EXIT_FAILURE;
+            }
+        }
+
+        //The batch trees should be equal to the ones created from scratch
+        Tree reference_tree;
+        if( !treeFromParModel(models[i],reference_tree) ) {cerr << "Could not generate kdl tree" << endl; return EXIT_FAILURE;}
+        if( reference_tree.getNrOfSegments() != trees[i].getNrOfSegments() ) {cerr << "Mismatch in the number of segments" << endl; return EXIT_FAILURE;}
+
+        const SegmentMap & reference_segments = reference_tree.getSegments();
+        for(SegmentMap::const_iterator it=reference_segments.begin(); it != reference_segments.end(); it++ ) {
+            SegmentMap::const_iterator batch_it = trees[i].getSegment(it->first);
+            if( batch_it == trees[i].getSegments().end() ) {cerr << "Missing segment " << it->first << endl; return EXIT_FAILURE;}
+            const Segment & reference_segment = it->second.segment;
+            const Segment & batch_segment = batch_it->second.segment;
+            double q = random_double();
+            if( !Equal(reference_segment.pose(q),batch_segment.pose(q),tol) ||
+                reference_segment.getJoint().getName() != batch_segment.getJoint().getName() ||
+                reference_segment.getJoint().getType() != batch_segment.getJoint().getType() ) {
+                std::cout << "Mismatch for segment " << it->first << " of instance " << i << std::endl;
+                std::cout << "reference " << reference_segment.pose(q) << std::endl;
+                std::cout << "batch     " << batch_segment.pose(q) << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    //The derivatives of the frames with respect to the symbolic parameters agree with the finite differences
+    const char * symbolic_par = "NL = 3\nNJ = 3\nNF = 3\nType = 1\nAnt = {0,1,1}\nSigma = {0,1,0}\nMu = {1,1,1}\n"
+                                "B = {0,B2,0.1}\nd = {0,D2,D3}\nR = {0.2,RL2,RL2}\ngamma = {0,G2,0.3}\n"
+                                "Alpha = {0,A2,-Pi/2}\nTheta = {t1,t2+0.4,t3}\n";
+    symoro_par_model symbolic_mdl;
+    if( !parModelFromString(symbolic_par,symbolic_mdl) ) {cerr << "Could not parse the symbolic model" << endl; return EXIT_FAILURE;}
+    const int nr_of_symbolic = symbolic_mdl.geometric_parameter_names.size();
+    std::vector<double> symbolic_values(nr_of_symbolic);
+    for(int p=0; p < nr_of_symbolic; p++ ) {
+        symbolic_values[p] = 0.5+random_double();
+    }
+    std::vector<double> joint_positions(symbolic_mdl.NL);
+    for(int l=0; l < symbolic_mdl.NL; l++ ) {
+        joint_positions[l] = random_double();
+    }
+
+    const double h = 1e-6;
+    for(int p=0; p < nr_of_symbolic; p++ ) {
+        //The derivatives are computed at the nominal values, the same point of the finite differences
+        Tree symbolic_tree;
+        std::vector<Twist> derivatives;
+        if( !treeFromParModel(symbolic_mdl,symbolic_tree) ||
+            !bindGeometricParameters(symbolic_mdl,symbolic_values,symbolic_tree) ||
+            !geometricParameterFrameDerivatives(symbolic_mdl,p,derivatives,joint_positions) ) {
+            cerr << "Could not compute the derivatives" << endl; return EXIT_FAILURE;
+        }
+
+        //frames[0] with the parameter increased by h, frames[1] decreased by h, frames[2] nominal
+        std::vector<Frame> frames[3];
+        for(int k=0; k < 3; k++ ) {
+            std::vector<double> perturbed_values = symbolic_values;
+            perturbed_values[p] += (k == 0 ? h : (k == 1 ? -h : 0.0));
+            if( !bindGeometricParameters(symbolic_mdl,perturbed_values,symbolic_tree) ) return EXIT_FAILURE;
+            for(int l=0; l < symbolic_mdl.NL; l++ ) {
+                char name[32];
+                sprintf(name,"Link%d",l+1);
+                frames[k].push_back(symbolic_tree.getSegment(name)->second.segment.pose(joint_positions[l]));
+            }
+        }
+
+        for(int l=0; l < symbolic_mdl.NL; l++ ) {
+            //Angular velocity from the skew-symmetric matrix dR/dp*R^T
+            Rotation dR_Rt = Rotation::Identity();
+            for(int i=0; i < 3; i++ ) {
+                for(int j=0; j < 3; j++ ) {
+                    double sum = 0;
+                    for(int k=0; k < 3; k++ ) {
+                        sum += (frames[0][l].M(i,k)-frames[1][l].M(i,k))/(2*h)*frames[2][l].M(j,k);
+                    }
+                    dR_Rt(i,j) = sum;
+                }
+            }
+            Vector vel = (frames[0][l].p-frames[1][l].p)/(2*h);
+            Vector rot(dR_Rt(2,1),dR_Rt(0,2),dR_Rt(1,0));
+            if( (vel-derivatives[l].vel).Norm() > 1e-6 || (rot-derivatives[l].rot).Norm() > 1e-6 ) {
+                std::cout << "Wrong derivative of link " << l+1 << " with respect to " << symbolic_mdl.geometric_parameter_names[p] << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
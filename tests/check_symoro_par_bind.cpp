@@ -0,0 +1,284 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl/frames_io.hpp>
+
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+/**
+ * Replace the symbolic parameters of a par file with their values
+ */
+std::string substituteParameters(const std::string & par, const std::vector<std::string> & names, const std::vector<double> & values)
+{
+    std::string numeric_par = par;
+    for(size_t p=0; p < names.size(); p++ ) {
+        char value[64];
+        sprintf(value,"%.17g",values[p]);
+        size_t pos = 0;
+        while( (pos = numeric_par.find(names[p],pos)) != std::string::npos ) {
+            //Replace only whole words
+            bool begins_word = pos == 0 || !isalnum(numeric_par[pos-1]);
+            bool ends_word = pos+names[p].size() == numeric_par.size() || !isalnum(numeric_par[pos+names[p].size()]);
+            if( begins_word && ends_word ) {
+                numeric_par.replace(pos,names[p].size(),value);
+                pos += strlen(value);
+            } else {
+                pos += names[p].size();
+            }
+        }
+    }
+    return numeric_par;
+}
+
+/**
+ * Check that two trees have the same segments, with the same poses
+ */
+bool checkSameTree(const Tree & reference_tree, const Tree & tree)
+{
+    if( reference_tree.getNrOfSegments() != tree.getNrOfSegments() ||
+        reference_tree.getRootSegment()->first != tree.getRootSegment()->first ) {
+        std::cout << "Mismatch in the structure of the trees" << std::endl;
+        return false;
+    }
+
+    const SegmentMap & reference_segments = reference_tree.getSegments();
+    for(SegmentMap::const_iterator it=reference_segments.begin(); it != reference_segments.end(); it++ ) {
+        SegmentMap::const_iterator tree_it = tree.getSegment(it->first);
+        if( tree_it == tree.getSegments().end() ) {
+            std::cout << "Missing segment " << it->first << std::endl;
+            return false;
+        }
+        const Segment & reference_segment = it->second.segment;
+        const Segment & segment = tree_it->second.segment;
+        double q = random_double();
+        if( !Equal(reference_segment.pose(q),segment.pose(q),1e-10) ||
+            reference_segment.getJoint().getName() != segment.getJoint().getName() ||
+            reference_segment.getJoint().getType() != segment.getJoint().getType() ) {
+            std::cout << "Mismatch for segment " << it->first << std::endl;
+            std::cout << "reference " << reference_segment.pose(q) << std::endl;
+            std::cout << "bound     " << segment.pose(q) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Bind random values to the symbolic geometric parameters of a par file, and compare
+ * the tree with the one of the par file where the parameters are replaced by the values
+ */
+bool checkGeometricBind(const std::string & symbolic_par, const bool consider_root_link_inertia)
+{
+    symoro_par_model symbolic_mdl;
+    Tree symbolic_tree;
+    if( !parModelFromString(symbolic_par,symbolic_mdl) || !treeFromParModel(symbolic_mdl,symbolic_tree,consider_root_link_inertia) ) {
+        std::cout << "Could not parse the symbolic model" << std::endl;
+        return false;
+    }
+
+    std::vector<double> values(symbolic_mdl.geometric_parameter_names.size());
+    for(size_t p=0; p < values.size(); p++ ) {
+        values[p] = random_double();
+    }
+
+    //Bind twice, to check also a tree already bound
+    for(int k=0; k < 2; k++ ) {
+        if( !bindGeometricParameters(symbolic_mdl,values,symbolic_tree) ) {
+            std::cout << "Could not bind the geometric parameters" << std::endl;
+            return false;
+        }
+
+        symoro_par_model numeric_mdl;
+        Tree numeric_tree;
+        std::string numeric_par = substituteParameters(symbolic_par,symbolic_mdl.geometric_parameter_names,values);
+        if( !parModelFromString(numeric_par,numeric_mdl) || !numeric_mdl.geometric_parameter_names.empty() ||
+            !treeFromParModel(numeric_mdl,numeric_tree,consider_root_link_inertia) ) {
+            std::cout << "Could not parse the numeric model" << std::endl;
+            return false;
+        }
+        if( !checkSameTree(numeric_tree,symbolic_tree) ) return false;
+
+        for(size_t p=0; p < values.size(); p++ ) {
+            values[p] += 0.1;
+        }
+    }
+    return true;
+}
+
+/**
+ * Check that the inertia of a segment corresponds to the SyMoRo inertial parameters of link l,
+ * that are expressed with respect to the origin of the link frame
+ */
+bool checkLinkInertia(const symoro_par_model & mdl, const int l, const RigidBodyInertia & inertia)
+{
+    double tol = 1e-10;
+    const RotationalInertia & I_o = inertia.getRotationalInertia();
+    double expected_I_o[9] = {mdl.XX[l], mdl.XY[l], mdl.XZ[l],
+                              mdl.XY[l], mdl.YY[l], mdl.YZ[l],
+                              mdl.XZ[l], mdl.YZ[l], mdl.ZZ[l]};
+    Vector expected_com = Vector(mdl.MX[l],mdl.MY[l],mdl.MZ[l])/mdl.M[l];
+    bool ok = fabs(inertia.getMass()-mdl.M[l]) < tol && Equal(inertia.getCOG(),expected_com,tol);
+    for(int i=0; i < 9; i++ ) {
+        ok = ok && fabs(I_o.data[i]-expected_I_o[i]) < tol;
+    }
+    if( !ok ) {
+        std::cout << "Wrong inertia of link " << l+1 << ": mass " << inertia.getMass() << " com " << inertia.getCOG() << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * Bind random values to the symbolic inertial parameters of a par file, and compare the
+ * inertia of the segments with the one of the par file where the parameters are replaced by the values
+ */
+bool checkInertialBind(const std::string & symbolic_par)
+{
+    symoro_par_model symbolic_mdl;
+    Tree symbolic_tree;
+    if( !parModelFromString(symbolic_par,symbolic_mdl) || !treeFromParModel(symbolic_mdl,symbolic_tree) ) {
+        std::cout << "Could not parse the symbolic model" << std::endl;
+        return false;
+    }
+
+    //Positive masses and inertias, so that the center of mass is defined
+    std::vector<double> values(symbolic_mdl.inertial_parameter_names.size());
+    for(size_t p=0; p < values.size(); p++ ) {
+        values[p] = 2.0+random_double();
+    }
+
+    if( !bindInertialParameters(symbolic_mdl,values,symbolic_tree) ) {
+        std::cout << "Could not bind the inertial parameters" << std::endl;
+        return false;
+    }
+
+    symoro_par_model numeric_mdl;
+    Tree numeric_tree;
+    std::string numeric_par = substituteParameters(symbolic_par,symbolic_mdl.inertial_parameter_names,values);
+    if( !parModelFromString(numeric_par,numeric_mdl) || !numeric_mdl.inertial_parameter_names.empty() ||
+        !treeFromParModel(numeric_mdl,numeric_tree) ) {
+        std::cout << "Could not parse the numeric model" << std::endl;
+        return false;
+    }
+    if( !checkSameTree(numeric_tree,symbolic_tree) ) return false;
+
+    for(int l=0; l < numeric_mdl.NL; l++ ) {
+        char name[32];
+        sprintf(name,"Link%d",l+1);
+        const RigidBodyInertia & bound_inertia = symbolic_tree.getSegment(name)->second.segment.getInertia();
+        const RigidBodyInertia & numeric_inertia = numeric_tree.getSegment(name)->second.segment.getInertia();
+        if( !checkLinkInertia(numeric_mdl,l,numeric_inertia) || !checkLinkInertia(symbolic_mdl,l,bound_inertia) ) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    srand(time(NULL));
+
+    //Symbolic d, R and Alpha, in a chain (with and without the fake base) and in a tree
+    const char * symbolic_chain = "NL = 3\nNJ = 3\nNF = 3\nType = 0\nAnt = {0,1,2}\nSigma = {0,0,1}\nMu = {1,1,1}\n"
+                                  "B = {0,0,0}\nd = {0,D2,D3}\nR = {RL1,0.1,RL3}\ngamma = {0,0,0}\n"
+                                  "Alpha = {0,AL2,Pi/2}\nTheta = {t1,t2+0.4,0.2}\n";
+    const char * symbolic_tree = "NL = 4\nNJ = 4\nNF = 4\nType = 1\nAnt = {0,1,1,3}\nSigma = {0,0,0,2}\nMu = {1,1,1,0}\n"
+                                 "B = {0,B2,0.1,0}\nd = {0,D2,D3,D3}\nR = {0.2,RL2,RL2,0}\ngamma = {0,G2,0.3,0}\n"
+                                 "Alpha = {0,AL2,-Pi/2,AL4}\nTheta = {t1,t2+0.4,t3,0}\n";
+
+    if( !checkGeometricBind(symbolic_chain,true) || !checkGeometricBind(symbolic_chain,false) ||
+        !checkGeometricBind(symbolic_tree,true) ) {
+        std::cerr << "Wrong tree with the geometric parameters bound" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Symbolic inertial parameters, mixed with numerical ones
+    const char * symbolic_inertial_tree = "NL = 3\nNJ = 3\nNF = 3\nType = 1\nAnt = {0,1,1}\nSigma = {0,0,0}\nMu = {1,1,1}\n"
+                                          "B = {0,0,0.1}\nd = {0,0.3,0.2}\nR = {0.2,0,0}\ngamma = {0,0,0.3}\n"
+                                          "Alpha = {0,Pi/2,-Pi/2}\nTheta = {t1,t2,t3}\n"
+                                          "XX = {XX1,XX2,3}\nXY = {XY1,0.01,XY3}\nXZ = {XZ1,0,0.02}\n"
+                                          "YY = {YY1,YY2,3.5}\nYZ = {YZ1,0,YZ3}\nZZ = {ZZ1,ZZ2,4}\n"
+                                          "MX = {MX1,MX2,0.3}\nMY = {MY1,0,MY3}\nMZ = {MZ1,MZ2,-0.2}\nM = {M1,M2,2.5}\n";
+    if( !checkInertialBind(symbolic_inertial_tree) ) {
+        std::cerr << "Wrong tree with the inertial parameters bound" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //The number of values and the structure of the tree are checked
+    symoro_par_model chain_mdl, tree_mdl;
+    Tree chain, tree;
+    if( !parModelFromString(symbolic_chain,chain_mdl) || !parModelFromString(symbolic_tree,tree_mdl) ||
+        !treeFromParModel(chain_mdl,chain) || !treeFromParModel(tree_mdl,tree) ) {
+        std::cerr << "Could not parse the symbolic models" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<double> chain_values(chain_mdl.geometric_parameter_names.size(),0.5);
+    if( bindGeometricParameters(chain_mdl,std::vector<double>(1,0.5),chain) ||
+        bindGeometricParameters(chain_mdl,chain_values,tree) ) {
+        std::cerr << "Wrong values or wrong tree not detected" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Only bare symbolic parameters are supported, an expression of a symbolic parameter is an error
+    const char * expressions[] = {"-D3", "2*D3", "D3+0.1", "sin(D3)"};
+    for(int e=0; e < 4; e++ ) {
+        std::string par = "NL = 2\nNJ = 2\nNF = 2\nType = 1\nAnt = {0,1}\nSigma = {0,0}\nMu = {1,1}\n"
+                          "B = {0,0}\nd = {0," + std::string(expressions[e]) + "}\nR = {0,0}\ngamma = {0,0}\n"
+                          "Alpha = {0,Pi/2}\nTheta = {t1,t2}\n";
+        symoro_par_model mdl;
+        if( parModelFromString(par,mdl) ) {
+            std::cerr << "The expression " << expressions[e] << " of a symbolic parameter was accepted" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+#include <kdl_format_io/symoro_par_export.hpp>
+
+#include <kdl_codyco/treefksolverpos_iterative.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/frames_io.hpp>
+
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+//Segments in the order used by the exporter (depth first)
+void addSegments(const SegmentMap::const_iterator & element, std::vector<SegmentMap::const_iterator> & segments)
+{
+    for(size_t c=0; c < element->second.children.size(); c++ ) {
+        segments.push_back(element->second.children[c]);
+        addSegments(element->second.children[c],segments);
+    }
+}
+
+//The joint axes and the inertia expressed in the world frame do not depend on the choice of the link frames
+bool checkLink(const Segment & original_segment, const Frame & original_parent_pose,
+               const Segment & exported_segment, const Frame & exported_parent_pose, double q, double tol)
+{
+    if( original_segment.getJoint().getType() != Joint::None ) {
+        Vector original_axis = original_parent_pose.M*original_segment.getJoint().JointAxis();
+        Vector exported_axis = exported_parent_pose.M*exported_segment.getJoint().JointAxis();
+        Vector origins = exported_parent_pose*exported_segment.getJoint().JointOrigin()-original_parent_pose*original_segment.getJoint().JointOrigin();
+        if( !Equal(original_axis,exported_axis,tol) || (origins*original_axis).Norm() > tol ) {
+            std::cout << "Mismatch in the joint axis " << original_axis << " " << exported_axis << std::endl;
+            return false;
+        }
+    }
+
+    RigidBodyInertia original_inertia = original_parent_pose*original_segment.pose(q)*original_segment.getInertia();
+    RigidBodyInertia exported_inertia = exported_parent_pose*exported_segment.pose(q)*exported_segment.getInertia();
+    RotationalInertia original_rot_inertia = original_inertia.getRotationalInertia();
+    RotationalInertia exported_rot_inertia = exported_inertia.getRotationalInertia();
+    if( fabs(original_inertia.getMass()-exported_inertia.getMass()) > tol ||
+        !Equal(original_inertia.getCOG()*original_inertia.getMass(),exported_inertia.getCOG()*exported_inertia.getMass(),tol) ) {
+        std::cout << "Mismatch in the mass or first moment of mass" << std::endl;
+        return false;
+    }
+    for(int i=0; i < 9; i++ ) {
+        if( fabs(original_rot_inertia.data[i]-exported_rot_inertia.data[i]) > tol ) {
+            std::cout << "Mismatch in the rotational inertia" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    srand(time(NULL));
+    if (argc < 2){
+        std::cerr << "Expect .par file to parse" << std::endl;
+        return -1;
+    }
+
+    Tree original_tree;
+    if( !treeFromSymoroParFile(argv[1],original_tree,true) ) {cerr << "Could not generate kdl tree" << endl; return EXIT_FAILURE;}
+
+    std::string parfile_content;
+    if( !treeToSymoroParString(original_tree,parfile_content,"exported_robot") ) {cerr << "Could not export kdl tree" << endl; return EXIT_FAILURE;}
+
+    Tree exported_tree;
+    if( !treeFromSymoroParString(parfile_content,exported_tree,false) ) {
+        cerr << "Could not import exported .par file:" << endl << parfile_content << endl; return EXIT_FAILURE;
+    }
+
+    std::vector<SegmentMap::const_iterator> segments;
+    addSegments(original_tree.getRootSegment(),segments);
+    if( exported_tree.getNrOfSegments() != segments.size() || exported_tree.getNrOfJoints() != original_tree.getNrOfJoints() ) {
+        cerr << "Mismatch in the number of links or joints" << endl; return EXIT_FAILURE;
+    }
+
+    KDL::CoDyCo::TreeFkSolverPos_iterative original_pos_slv(original_tree);
+    KDL::CoDyCo::TreeFkSolverPos_iterative exported_pos_slv(exported_tree);
+
+    const int nr_of_configurations = 10;
+    double q_range = 3;
+    double tol = 1e-8;
+
+    for(int c=0; c < nr_of_configurations; c++ ) {
+        JntArray original_q(original_tree.getNrOfJoints());
+        JntArray exported_q(exported_tree.getNrOfJoints());
+        for(int i=0; i < (int)original_q.rows(); i++ ) { original_q(i) = q_range*random_double(); }
+
+        for(size_t l=0; l < segments.size(); l++ ) {
+            char link_name[32];
+            sprintf(link_name,"Link%d",(int)l+1);
+            SegmentMap::const_iterator exported_element = exported_tree.getSegment(link_name);
+            if( segments[l]->second.segment.getJoint().getType() != Joint::None ) {
+                exported_q(exported_element->second.q_nr) = original_q(segments[l]->second.q_nr);
+            }
+        }
+
+        for(size_t l=0; l < segments.size(); l++ ) {
+            char link_name[32];
+            sprintf(link_name,"Link%d",(int)l+1);
+            SegmentMap::const_iterator exported_element = exported_tree.getSegment(link_name);
+            const Segment & original_segment = segments[l]->second.segment;
+            const Segment & exported_segment = exported_element->second.segment;
+
+            Frame original_parent_pose, exported_parent_pose;
+            if( original_pos_slv.JntToCart(original_q,original_parent_pose,segments[l]->second.parent->first) != 0 ||
+                exported_pos_slv.JntToCart(exported_q,exported_parent_pose,exported_element->second.parent->first) != 0 ) {
+                cerr << "Failed geom solver for " << link_name << endl; return EXIT_FAILURE;
+            }
+
+            double q = original_segment.getJoint().getType() == Joint::None ? 0.0 : original_q(segments[l]->second.q_nr);
+            if( !checkLink(original_segment,original_parent_pose,exported_segment,exported_parent_pose,q,tol) ) {
+                std::cout << "Mismatch for " << original_segment.getName() << " (" << link_name << ")" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_expression_cache.hpp>
+
+#include <pthread.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+using namespace kdl_format_io;
+
+const int nr_of_threads = 8;
+const int nr_of_operations = 20000;
+const int nr_of_expressions = 100;
+
+//Smaller than the number of expressions, so the threads also evict the expressions of the others
+const int max_nr_of_expressions = 32;
+
+struct thread_data
+{
+    symoro_par_expression_cache * cache;
+    int thread;
+    int nr_of_wrong_values;
+    long nr_of_lookups;
+};
+
+/**
+ * The value of each expression depends only on its text, so every value
+ * found in the cache must be the one of the looked up expression
+ */
+double expressionValue(const int e)
+{
+    return 0.5*e-3.0;
+}
+
+void * lookupAndInsert(void * arg)
+{
+    thread_data & data = *static_cast<thread_data *>(arg);
+    for(int i=0; i < nr_of_operations; i++ ) {
+        int e = (7*i+13*data.thread) % nr_of_expressions;
+        char expression[32];
+        int length = sprintf(expression,"Pi/%d+t%d",e,e % 5);
+        double value;
+        data.nr_of_lookups++;
+        if( data.cache->lookup(expression,expression+length,value) ) {
+            if( value != expressionValue(e) ) data.nr_of_wrong_values++;
+        } else {
+            data.cache->insert(expression,expression+length,expressionValue(e));
+        }
+    }
+    return 0;
+}
+
+int main()
+{
+    symoro_par_expression_cache cache(max_nr_of_expressions);
+
+    pthread_t threads[nr_of_threads];
+    thread_data data[nr_of_threads];
+    for(int t=0; t < nr_of_threads; t++ ) {
+        data[t].cache = &cache;
+        data[t].thread = t;
+        data[t].nr_of_wrong_values = 0;
+        data[t].nr_of_lookups = 0;
+        if( pthread_create(&threads[t],0,lookupAndInsert,&data[t]) != 0 ) {cerr << "Could not create thread " << t << endl; return EXIT_FAILURE;}
+    }
+
+    long nr_of_lookups = 0;
+    int nr_of_wrong_values = 0;
+    for(int t=0; t < nr_of_threads; t++ ) {
+        pthread_join(threads[t],0);
+        nr_of_lookups += data[t].nr_of_lookups;
+        nr_of_wrong_values += data[t].nr_of_wrong_values;
+    }
+
+    if( nr_of_wrong_values != 0 ) {
+        cerr << nr_of_wrong_values << " wrong values found in the cache" << endl; return EXIT_FAILURE;
+    }
+    if( cache.getNrOfLookups() != nr_of_lookups || cache.getNrOfHits() > nr_of_lookups ||
+        cache.getNrOfExpressions() > max_nr_of_expressions ) {
+        cerr << "Wrong statistics of the cache: " << cache.getNrOfLookups() << " lookups instead of " << nr_of_lookups
+             << ", " << cache.getNrOfExpressions() << " expressions" << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
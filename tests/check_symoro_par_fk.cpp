@@ -0,0 +1,117 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+
+#include <kdl_format_io/symoro_par_import.hpp>
+#include <kdl_format_io/symoro_par_fk.hpp>
+
+#include <kdl_codyco/treefksolverpos_iterative.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/frames_io.hpp>
+
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace KDL;
+using namespace std;
+using namespace kdl_format_io;
+
+double random_double()
+{
+    return ((double)rand()-RAND_MAX/2)/((double)RAND_MAX);
+}
+
+int main(int argc, char** argv)
+{
+    srand(time(NULL));
+    if (argc < 2){
+        std::cerr << "Expect .par file to parse" << std::endl;
+        return -1;
+    }
+
+    symoro_par_model mdl;
+    if( !parModelFromFile(argv[1],mdl) ) {cerr << "Could not parse SyMoRo par robot model" << endl; return EXIT_FAILURE;}
+
+    Tree my_tree;
+    if( !treeFromParModel(mdl,my_tree,true) ) {cerr << "Could not generate kdl tree" << endl; return EXIT_FAILURE;}
+
+    symoro_par_fk_solver par_fk(mdl);
+    if( !par_fk.isValid() ) {cerr << "Could not create par fk solver" << endl; return EXIT_FAILURE;}
+    if( par_fk.getNrOfDOFs() != (int)my_tree.getNrOfJoints() ) {cerr << "Mismatch in the number of DOFs" << endl; return EXIT_FAILURE;}
+
+    KDL::CoDyCo::TreeFkSolverPos_iterative pos_slv(my_tree);
+
+    const int nr_of_configurations = 10;
+    const int nr_of_dofs = par_fk.getNrOfDOFs();
+    const int nr_of_links = par_fk.getNrOfLinks();
+    double q_range = 3;
+    double tol = 1e-10;
+
+    std::vector<double> q_batch(nr_of_configurations*nr_of_dofs);
+    for(int i=0; i < (int)q_batch.size(); i++ ) { q_batch[i] = q_range*random_double(); }
+
+    std::vector<Frame> poses_batch(nr_of_configurations*nr_of_links);
+    if( !par_fk.JntToCartBatch(nr_of_dofs > 0 ? &q_batch[0] : 0,nr_of_configurations,&poses_batch[0]) ) {
+        cerr << "par fk batch failed" << endl; return EXIT_FAILURE;
+    }
+
+    for(int c=0; c < nr_of_configurations; c++ ) {
+        JntArray q(nr_of_dofs);
+        std::vector<double> q_vec(nr_of_dofs);
+        for(int i=0; i < nr_of_dofs; i++ ) { q(i) = q_vec[i] = q_batch[c*nr_of_dofs+i]; }
+
+        std::vector<Frame> poses;
+        if( !par_fk.JntToCart(q_vec,poses) ) { cerr << "par fk failed" << endl; return EXIT_FAILURE; }
+
+        for(int l=0; l < nr_of_links; l++ ) {
+            char link_name[32];
+            sprintf(link_name,"Link%d",l+1);
+            Frame H_kdl;
+            if( pos_slv.JntToCart(q,H_kdl,link_name) != 0 ) { cerr << "Failed geom solver for " << link_name << endl; return EXIT_FAILURE; }
+
+            if( !Equal(H_kdl,poses[l],tol) || !Equal(H_kdl,poses_batch[c*nr_of_links+l],tol) ) {
+                std::cout << "Mismatch for " << link_name << std::endl;
+                std::cout << "H_kdl    " << H_kdl << std::endl;
+                std::cout << "H_par_fk " << poses[l] << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+#include <kdl_format_io/symoro_par_import_serialization.hpp>
+
+#include <kdl/tree.hpp>
+#include <kdl_codyco/treeserialization.hpp>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+using namespace KDL;
+using namespace KDL::CoDyCo;
+using namespace std;
+using namespace kdl_format_io;
+
+std::string linkName(const int l)
+{
+    char name[32];
+    sprintf(name,"Link%d",l);
+    return name;
+}
+
+std::string jointName(const int j)
+{
+    char name[32];
+    sprintf(name,"Joint%d",j);
+    return name;
+}
+
+bool checkID(const char * kind, const std::string & name, const int id, const int expected_id)
+{
+    if( id != expected_id ) {
+        std::cout << "Wrong " << kind << " ID of " << name << ": " << id << " instead of " << expected_id << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check the serialization of a chain: the moving joints are the first junctions (with the
+ * id of their DOF) followed by the fixed ones, the fake base (if any) is the first link
+ * and its fixed joint is the first fixed junction
+ */
+bool checkChainSerialization(const symoro_par_model & mdl, const TreeSerialization & serialization, const bool has_fake_base)
+{
+    int nr_of_dofs = 0;
+    for(int l=0; l < mdl.NL; l++ ) {
+        if( mdl.Sigma[l] != 2 ) nr_of_dofs++;
+    }
+    int nr_of_fake_links = has_fake_base ? 1 : 0;
+
+    if( serialization.getNrOfDOFs() != nr_of_dofs || serialization.getNrOfLinks() != mdl.NL+1+nr_of_fake_links ||
+        serialization.getNrOfJunctions() != mdl.NL+nr_of_fake_links ) {
+        std::cout << "Wrong size of the serialization: " << serialization.getNrOfDOFs() << " DOFs, " << serialization.getNrOfLinks()
+                  << " links, " << serialization.getNrOfJunctions() << " junctions" << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    int fixed_junction_cnt = 0;
+    if( has_fake_base ) {
+        ok = checkID("link","FakeBase_introduced_by_symoro_par_import",serialization.getLinkID("FakeBase_introduced_by_symoro_par_import"),0) && ok;
+        ok = checkID("junction","FakeFixedJoint_introduced_by_symoro_par_import",
+                     serialization.getJunctionID("FakeFixedJoint_introduced_by_symoro_par_import"),nr_of_dofs) && ok;
+        fixed_junction_cnt++;
+    }
+
+    int dof_cnt = 0;
+    for(int l=0; l <= mdl.NL; l++ ) {
+        ok = checkID("link",linkName(l),serialization.getLinkID(linkName(l)),l+nr_of_fake_links) && ok;
+    }
+    //Joints of chains are numbered from 0
+    for(int l=0; l < mdl.NL; l++ ) {
+        if( mdl.Sigma[l] != 2 ) {
+            ok = checkID("DOF",jointName(l),serialization.getDOFID(jointName(l)),dof_cnt) && ok;
+            ok = checkID("junction",jointName(l),serialization.getJunctionID(jointName(l)),dof_cnt) && ok;
+            dof_cnt++;
+        } else {
+            ok = checkID("junction",jointName(l),serialization.getJunctionID(jointName(l)),nr_of_dofs+fixed_junction_cnt) && ok;
+            fixed_junction_cnt++;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Check that the links and the moving joints of the serialization are in the tree
+ */
+bool checkTreeNames(const Tree & tree, const TreeSerialization & serialization)
+{
+    for(int l=0; l < serialization.getNrOfLinks(); l++ ) {
+        if( tree.getSegment(serialization.getLinkName(l)) == tree.getSegments().end() ) {
+            std::cout << "Link " << serialization.getLinkName(l) << " not found in the tree" << std::endl;
+            return false;
+        }
+    }
+    if( (int)tree.getNrOfJoints() != serialization.getNrOfDOFs() ) {
+        std::cout << "Wrong number of joints in the tree" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2){
+        std::cerr << "Expect .par file of a chain to parse" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    symoro_par_model mdl;
+    if( !parModelFromFile(argv[1],mdl) || mdl.Type != 0 ) {cerr << "Could not parse the SyMoRo par chain" << endl; return EXIT_FAILURE;}
+
+    //Chain of the file, with and without the fake base
+    for(int k=0; k < 2; k++ ) {
+        bool consider_root_link_inertia = (k == 0);
+        TreeSerialization serialization, tree_serialization;
+        Tree tree;
+        if( !treeSerializationFromSymoroParFile(argv[1],serialization,consider_root_link_inertia) ||
+            !treeAndSerializationFromSymoroParFile(argv[1],tree,tree_serialization,consider_root_link_inertia) ) {
+            cerr << "Could not generate the serialization" << endl; return EXIT_FAILURE;
+        }
+        if( !checkChainSerialization(mdl,serialization,consider_root_link_inertia) ||
+            !checkChainSerialization(mdl,tree_serialization,consider_root_link_inertia) ||
+            !checkTreeNames(tree,tree_serialization) ) {
+            cerr << "Wrong serialization of " << argv[1] << endl; return EXIT_FAILURE;
+        }
+    }
+
+    //Chain with a fixed joint, that is a junction but not a DOF
+    const char * chain_with_fixed_joint = "NL = 4\nNJ = 4\nNF = 4\nType = 0\nAnt = {0,1,2,3}\nSigma = {0,2,1,0}\nMu = {1,0,1,1}\n"
+                                          "B = {0,0,0,0}\nd = {0,0.1,0.2,0}\nR = {0,0.3,0,0.1}\ngamma = {0,0,0,0}\n"
+                                          "Alpha = {0,Pi/2,0,-Pi/2}\nTheta = {t1,0,0.5,t4}\n";
+    symoro_par_model fixed_mdl;
+    if( !parModelFromString(chain_with_fixed_joint,fixed_mdl) ) {cerr << "Could not parse the chain with a fixed joint" << endl; return EXIT_FAILURE;}
+    for(int k=0; k < 2; k++ ) {
+        bool consider_root_link_inertia = (k == 0);
+        TreeSerialization serialization;
+        Tree tree;
+        if( !treeAndSerializationFromSymoroParString(chain_with_fixed_joint,tree,serialization,consider_root_link_inertia) ||
+            !checkChainSerialization(fixed_mdl,serialization,consider_root_link_inertia) || !checkTreeNames(tree,serialization) ) {
+            cerr << "Wrong serialization of the chain with a fixed joint" << endl; return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
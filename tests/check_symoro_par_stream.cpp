@@ -0,0 +1,111 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2013 Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include <kdl_format_io/symoro_par_import.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+using namespace kdl_format_io;
+
+/**
+ * Read-only stream buffer returning at most chunk_size bytes at each underflow,
+ * to exercise the refills of the buffer of parModelFromStream
+ */
+class chunked_streambuf : public std::streambuf
+{
+public:
+    chunked_streambuf(const std::string & _content, const int _chunk_size):
+        content(_content), chunk_size(_chunk_size), pos(0)
+    {
+    }
+
+protected:
+    virtual int_type underflow()
+    {
+        if( pos >= content.size() ) {
+            return traits_type::eof();
+        }
+        size_t len = content.size()-pos;
+        if( len > chunk_size ) len = chunk_size;
+        char * begin = &content[pos];
+        setg(begin,begin,begin+len);
+        pos += len;
+        return traits_type::to_int_type(*begin);
+    }
+
+private:
+    std::string content;
+    size_t chunk_size;
+    size_t pos;
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 2){
+        std::cerr << "Expect .par files to parse" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for(int f=1; f < argc; f++ ) {
+        std::ifstream parfile(argv[f]);
+        if( !parfile ) {cerr << "Could not open " << argv[f] << endl; return EXIT_FAILURE;}
+        std::stringstream parfile_content;
+        parfile_content << parfile.rdbuf();
+
+        symoro_par_model string_mdl;
+        if( !parModelFromString(parfile_content.str(),string_mdl) ) {cerr << "Could not parse " << argv[f] << endl; return EXIT_FAILURE;}
+        std::string expected = string_mdl.toString();
+
+        for(int chunk_size=1; chunk_size <= 7; chunk_size++ ) {
+            chunked_streambuf buf(parfile_content.str(),chunk_size);
+            std::istream chunked_stream(&buf);
+            symoro_par_model stream_mdl;
+            if( !parModelFromStream(chunked_stream,stream_mdl) ) {
+                cerr << "Could not parse " << argv[f] << " read by chunks of " << chunk_size << " bytes" << endl; return EXIT_FAILURE;
+            }
+            if( stream_mdl.toString() != expected ) {
+                cerr << "Different model from " << argv[f] << " read by chunks of " << chunk_size << " bytes" << endl; return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2014, Fondazione Istituto Italiano di Tecnologia
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Silvio Traversaro */
+#include "kdl_format_io/urdf_sensor_import.hpp"
+#include <kdl/tree.hpp>
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace kdl_format_io;
+
+//The sensors are defined before and after the links and joints they refer to
+const char * urdf_with_sensors =
+"<robot name=\"sensorized\">\n"
+"  <gazebo reference=\"torso\">\n"
+"    <sensor name=\"torso_imu\" type=\"imu\"> <pose>0 0 0.1 0 0 1.5707963267948966</pose> </sensor>\n"
+"    <sensor name=\"torso_camera\" type=\"camera\"/>\n"
+"  </gazebo>\n"
+"  <link name=\"base\"> <inertial> <mass value=\"1\"/> <inertia ixx=\"1\" ixy=\"0\" ixz=\"0\" iyy=\"1\" iyz=\"0\" izz=\"1\"/> </inertial> </link>\n"
+"  <link name=\"torso\"> <inertial> <mass value=\"1\"/> <inertia ixx=\"1\" ixy=\"0\" ixz=\"0\" iyy=\"1\" iyz=\"0\" izz=\"1\"/> </inertial> </link>\n"
+"  <link name=\"arm\"> <inertial> <mass value=\"1\"/> <inertia ixx=\"1\" ixy=\"0\" ixz=\"0\" iyy=\"1\" iyz=\"0\" izz=\"1\"/> </inertial> </link>\n"
+"  <joint name=\"torso_joint\" type=\"revolute\"> <parent link=\"base\"/> <child link=\"torso\"/> <axis xyz=\"0 0 1\"/>\n"
+"    <limit lower=\"-1\" upper=\"1\" effort=\"10\" velocity=\"1\"/> </joint>\n"
+"  <joint name=\"arm_ft_joint\" type=\"fixed\"> <parent link=\"torso\"/> <child link=\"arm\"/> <origin xyz=\"0 0.2 0\"/> </joint>\n"
+"  <gazebo reference=\"arm_ft_joint\">\n"
+"    <sensor name=\"arm_ft\" type=\"force_torque\"> <force_torque/> <frame>sensor</frame>\n"
+"      <measure_direction>parent_to_child</measure_direction> <pose>0.01 0.02 0.03 0 0 0</pose> </sensor>\n"
+"  </gazebo>\n"
+"  <gazebo reference=\"arm\">\n"
+"    <sensor name=\"arm_acc\" type=\"accelerometer\"> <pose>1 2 3 0 0 0</pose> </sensor>\n"
+"    <sensor name=\"arm_gyro\" type=\"gyroscope\"/>\n"
+"    <sensor name=\"hand_gyro\" type=\"gyroscope\"/>\n"
+"  </gazebo>\n"
+"  <gazebo reference=\"missing_link\">\n"
+"    <sensor name=\"lost_imu\" type=\"imu\"/>\n"
+"  </gazebo>\n"
+"</robot>\n";
+
+bool checkTable(const SensorTables & sensors, const int type, const size_t expected_size,
+                const size_t s, const char * name, const int parent_index)
+{
+    const SensorTable & table = sensors.tables[type];
+    if( table.size() != expected_size || table.parent_names.size() != expected_size ||
+        table.parent_indices.size() != expected_size || table.poses.size() != expected_size ) {
+        std::cout << "Wrong number of " << SensorTables::sensorTypeName(type) << " sensors: " << table.size() << std::endl;
+        return false;
+    }
+    if( table.names[s] != name || table.parent_indices[s] != parent_index ) {
+        std::cout << "Wrong " << SensorTables::sensorTypeName(type) << " sensor " << s << ": " << table.names[s]
+                  << " with parent " << table.parent_indices[s] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool ok = true;
+
+    SensorTables sensors;
+    if( !sensorsFromUrdfString(urdf_with_sensors,sensors) ) {
+        std::cout << "Could not extract the sensors" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( sensors.link_names.size() != 3 || sensors.joint_names.size() != 2 ) {
+        std::cout << "Wrong number of links or joints" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ok = checkTable(sensors,SensorTables::FORCE_TORQUE,1,0,"arm_ft",1) && ok;
+    ok = checkTable(sensors,SensorTables::IMU,2,0,"torso_imu",1) && ok;
+    ok = checkTable(sensors,SensorTables::IMU,2,1,"lost_imu",-1) && ok;
+    ok = checkTable(sensors,SensorTables::ACCELEROMETER,1,0,"arm_acc",2) && ok;
+    ok = checkTable(sensors,SensorTables::GYROSCOPE,2,1,"hand_gyro",2) && ok;
+
+    KDL::Frame imu_pose = sensors.tables[SensorTables::IMU].poses[0];
+    KDL::Frame expected_imu_pose(KDL::Rotation::RotZ(1.5707963267948966),KDL::Vector(0,0,0.1));
+    if( !KDL::Equal(imu_pose,expected_imu_pose) ) {
+        std::cout << "Wrong pose of the imu" << std::endl;
+        ok = false;
+    }
+    if( !KDL::Equal(sensors.tables[SensorTables::GYROSCOPE].poses[0],KDL::Frame::Identity()) ) {
+        std::cout << "The default pose is not the identity" << std::endl;
+        ok = false;
+    }
+
+    //The force_torque sensors are the same of ftSensorsFromUrdfString
+    std::vector<FTSensorData> ft_sensors;
+    if( !ftSensorsFromUrdfString(urdf_with_sensors,ft_sensors) || ft_sensors.size() != 1 ) {
+        std::cout << "Could not extract the force_torque sensors" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if( ft_sensors[0].sensor_name != "arm_ft" || ft_sensors[0].reference_joint != "arm_ft_joint" ||
+        ft_sensors[0].frame != FTSensorData::SENSOR_FRAME || ft_sensors[0].measure_direction != FTSensorData::PARENT_TO_CHILD ||
+        !KDL::Equal(ft_sensors[0].sensor_pose,sensors.tables[SensorTables::FORCE_TORQUE].poses[0]) ||
+        !KDL::Equal(ft_sensors[0].sensor_pose.p,KDL::Vector(0.01,0.02,0.03)) ) {
+        std::cout << "Wrong force_torque sensor" << std::endl;
+        ok = false;
+    }
+
+    //A malformed pose is an error
+    std::string malformed_urdf = "<robot name=\"r\"><gazebo reference=\"l\"><sensor name=\"s\" type=\"imu\"><pose>1 2 3</pose></sensor></gazebo></robot>";
+    if( sensorsFromUrdfString(malformed_urdf,sensors) ) {
+        std::cout << "A malformed pose was accepted" << std::endl;
+        ok = false;
+    }
+
+    //The malformed pose of an imu does not prevent the extraction of the force_torque sensors
+    std::string malformed_imu_urdf = "<robot name=\"r\"><gazebo reference=\"l\"><sensor name=\"s\" type=\"imu\"><pose>1 2 3</pose></sensor></gazebo>"
+                                     "<gazebo reference=\"j\"><sensor name=\"ft\" type=\"force_torque\"><pose>1 2 3 0 0 0</pose></sensor></gazebo></robot>";
+    if( !ftSensorsFromUrdfString(malformed_imu_urdf,ft_sensors) || ft_sensors.size() != 1 ||
+        !KDL::Equal(ft_sensors[0].sensor_pose.p,KDL::Vector(1,2,3)) ) {
+        std::cout << "The force_torque sensors were not extracted with a malformed imu pose" << std::endl;
+        ok = false;
+    }
+
+    //Tree and sensors from the same string
+    KDL::Tree tree;
+    if( !treeAndSensorsFromUrdfString(urdf_with_sensors,tree,sensors) || sensors.tables[SensorTables::GYROSCOPE].size() != 2 ) {
+        std::cout << "Could not extract the tree and the sensors" << std::endl;
+        ok = false;
+    }
+    if( tree.getNrOfSegments() != 2 ) {
+        std::cout << "Wrong number of segments: " << tree.getNrOfSegments() << std::endl;
+        ok = false;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}